@@ -18,11 +18,20 @@
                 "src/xml_namespace.cc",
                 "src/xml_node.cc",
                 "src/xml_sax_parser.cc",
+                "src/xml_schema.cc",
+                "src/xml_schematron_schema.cc",
                 "src/xml_syntax_error.cc",
                 "src/xml_textwriter.cc",
                 "src/xml_text.cc",
                 "src/xml_pi.cc",
+                "src/xml_relaxng_schema.cc",
                 "src/xml_xpath_context.cc",
+                "src/xml_xpath_expression.cc",
+                "src/xml_xpath_iterator.cc",
+                "src/xml_node_index.cc",
+                "src/xml_css_selector.cc",
+                "src/xml_js_object.cc",
+                "src/xml_cursor.cc",
                 "vendor/libxml/buf.c",
                 "vendor/libxml/catalog.c",
                 "vendor/libxml/chvalid.c",
@@ -64,6 +73,14 @@
                 "vendor/libxml/xpointer.c",
             ],
             "conditions": [
+                [
+                    # the async jobs run libxml on the libuv threadpool;
+                    # with thread support its global state (last error,
+                    # error handlers) is kept per thread
+                    'OS=="win"',
+                    {"defines": ["LIBXML_THREAD_ENABLED", "HAVE_WIN32_THREADS"]},
+                    {"defines": ["LIBXML_THREAD_ENABLED", "HAVE_PTHREAD_H"]},
+                ],
                 [
                     'OS=="mac"',
                     {
@@ -0,0 +1,72 @@
+// Measures how long the garbage collector takes to finalize the wrappers
+// of a large detached tree. The time per node should stay flat as the
+// tree grows. The second run does the same for a single deep branch,
+// every level of it wrapped, which must not run out of stack.
+//
+//   node --expose-gc examples/wrapper_gc_benchmark.js
+
+const libxml = require('../');
+
+if (!global.gc) {
+  throw new Error('run with --expose-gc');
+}
+
+function collectGarbage() {
+  for (let i = 0; i < 5; i += 1) {
+    global.gc();
+  }
+}
+
+function finalizeTree(size) {
+  (function build() {
+    const doc = new libxml.Document();
+    const fragment = new libxml.Element(doc, 'fragment');
+    const items = [];
+    for (let i = 0; i < size; i += 1) {
+      items.push(fragment.node('item').node('leaf', String(i)));
+    }
+  })();
+
+  const start = process.hrtime.bigint();
+  collectGarbage();
+  return Number(process.hrtime.bigint() - start) / 1e6;
+}
+
+function finalizeDeepTree(depth) {
+  (function build() {
+    const doc = new libxml.Document();
+    let node = new libxml.Element(doc, 'branch');
+    const levels = [node];
+    for (let i = 1; i < depth; i += 1) {
+      node = node.node('level');
+      levels.push(node);
+    }
+    // the lower half moves its wrappers along to a tree of its own
+    levels[depth >> 1].remove();
+  })();
+
+  const start = process.hrtime.bigint();
+  collectGarbage();
+  return Number(process.hrtime.bigint() - start) / 1e6;
+}
+
+collectGarbage();
+for (let size = 1000; size <= 64000; size *= 2) {
+  const ms = finalizeTree(size);
+  console.log(
+    '%d nodes: %s ms, %s us/node',
+    size,
+    ms.toFixed(1),
+    ((ms * 1000) / size).toFixed(2)
+  );
+}
+
+for (let depth = 1250; depth <= 20000; depth *= 2) {
+  const ms = finalizeDeepTree(depth);
+  console.log(
+    'depth %d: %s ms, %s us/level',
+    depth,
+    ms.toFixed(1),
+    ((ms * 1000) / depth).toFixed(2)
+  );
+}
@@ -44,25 +44,122 @@ interface ParserOptions {
   baseUrl?: string;
 }
 
+interface EvaluateManyOptions {
+  /**
+   * Default namespace uri or prefix map, as accepted by find()
+   */
+  namespaces?: string | StringMap;
+  variables?: XPathVariables;
+}
+
+/**
+ * Values bound to $name variables of XPath expressions
+ */
+interface XPathVariables {
+  [name: string]: string | number | boolean | Node | Node[];
+}
+
+interface HtmlParserOptions extends ParserOptions {
+  encoding?: string;
+  excludeImpliedElements?: boolean;
+}
+
 export function parseXml(source: string, options?: ParserOptions): Document;
 export function parseXmlString(
   source: string,
   options?: ParserOptions
 ): Document;
+/**
+ * Parses on the libuv threadpool instead of the main thread.
+ * A Buffer source must not be modified until the promise has settled.
+ */
+export function parseXmlAsync(
+  source: string | Buffer,
+  options?: ParserOptions
+): Promise<Document>;
 
 export function parseHtml(source: string, options?: ParserOptions): Document;
 export function parseHtmlString(
   source: string,
   options?: ParserOptions
 ): Document;
+/**
+ * Parses on the libuv threadpool instead of the main thread.
+ * A Buffer source must not be modified until the promise has settled.
+ */
+export function parseHtmlAsync(
+  source: string | Buffer,
+  options?: HtmlParserOptions
+): Promise<Document>;
 export function parseHtmlFragment(
   source: string,
   options?: ParserOptions
 ): Document;
 
+/**
+ * Compile an XSD schema document once, to validate any number of documents.
+ */
+export function compileSchema(xsdDoc: Document): Schema;
+/**
+ * Compile a RELAX NG grammar document once, to validate any number of documents.
+ */
+export function compileRelaxNGSchema(rngDoc: Document): RelaxNGSchema;
+/**
+ * Compile a Schematron document, including its XPath assertions, once.
+ */
+export function compileSchematronSchema(schDoc: Document): SchematronSchema;
+
+/**
+ * Compile an XPath expression once, to be used with find() and get().
+ */
+export function compileXPath(expression: string): XPathExpression;
+/**
+ * Number of string expressions whose compiled form is cached, 0 disables it.
+ */
+export function setXPathCacheSize(size: number): void;
+export function xpathCacheStats(): {
+  size: number;
+  capacity: number;
+  hits: number;
+  misses: number;
+};
+
 export function memoryUsage(): number;
 export function nodeCount(): number;
 
+/**
+ * The nodes of a document in document order, node i being described by
+ * the i-th entry of each array. Links are indexes, -1 when there is none.
+ */
+export interface FlatTree {
+  length: number;
+  parent: Int32Array;
+  firstChild: Int32Array;
+  nextSibling: Int32Array;
+  /** the DOM node type: 1 element, 3 text, 4 cdata, 7 PI, 8 comment... */
+  nodeType: Uint8Array;
+  /** index into names, -1 for text and comments */
+  nameId: Int32Array;
+  names: string[];
+  /** node i has the utf-8 text between textOffset[i] and textOffset[i + 1] */
+  textOffset: Uint32Array;
+  text: Buffer;
+}
+
+export interface WalkOptions {
+  /** the node types to visit, as in FlatTree.nodeType, all by default */
+  types?: number[];
+  /** how deep below the element to go, 0 for just the element */
+  maxDepth?: number;
+}
+
+export interface FromObjectOptions {
+  /** marks attribute keys, "@" by default */
+  attributePrefix?: string;
+  /** key of text content, "#text" by default */
+  textKey?: string;
+}
+
 export class Document {
   /**
    * Create a new XML Document
@@ -71,6 +168,12 @@ export class Document {
    */
   constructor(version?: string, encoding?: string);
 
+  /**
+   * Build a document from {rootName: content} in one native call, the
+   * shape toObject() returns. "@xmlns" keys declare namespaces.
+   */
+  static fromObject(obj: object, options?: FromObjectOptions): Document;
+
   errors: SyntaxError[];
   validationErrors: ValidationError[];
 
@@ -78,17 +181,127 @@ export class Document {
   childNodes(): Node[];
   encoding(): string;
   encoding(enc: string): this;
-  find<T extends Node = Node>(xpath: string, ns_uri?: string): T[];
-  find<T extends Node = Node>(xpath: string, namespaces: StringMap): T[];
-  get<T extends Node = Node>(xpath: string, ns_uri?: string): T | null;
-  get<T extends Node = Node>(xpath: string, namespaces: StringMap): T | null;
+  find<T extends Node = Node>(
+    xpath: string | XPathExpression,
+    ns_uri?: string,
+    variables?: XPathVariables
+  ): T[];
+  find<T extends Node = Node>(
+    xpath: string | XPathExpression,
+    namespaces: StringMap,
+    variables?: XPathVariables
+  ): T[];
+  get<T extends Node = Node>(
+    xpath: string | XPathExpression,
+    ns_uri?: string,
+    variables?: XPathVariables
+  ): T | null;
+  get<T extends Node = Node>(
+    xpath: string | XPathExpression,
+    namespaces: StringMap,
+    variables?: XPathVariables
+  ): T | null;
+  /**
+   * The string-value of every matching node, no node wrappers are created.
+   */
+  findStrings(
+    xpath: string | XPathExpression,
+    namespaces?: string | StringMap,
+    variables?: XPathVariables
+  ): string[];
+  /**
+   * The values of the matching attribute nodes, other nodes are skipped.
+   */
+  findAttrValues(
+    xpath: string | XPathExpression,
+    namespaces?: string | StringMap,
+    variables?: XPathVariables
+  ): string[];
+  count(
+    xpath: string | XPathExpression,
+    namespaces?: string | StringMap,
+    variables?: XPathVariables
+  ): number;
+  /**
+   * Lazily iterate over the matching nodes, wrapping each only once reached.
+   * Throws if the document is modified during the iteration.
+   */
+  iterate(
+    xpath: string | XPathExpression,
+    namespaces?: string | StringMap,
+    variables?: XPathVariables
+  ): XPathIterator;
+  evaluateMany<K extends string>(
+    expressions: Record<K, string | XPathExpression>,
+    options?: EvaluateManyOptions & { as?: 'string' }
+  ): Record<K, string>;
+  evaluateMany<K extends string>(
+    expressions: Record<K, string | XPathExpression>,
+    options: EvaluateManyOptions & { as: 'number' }
+  ): Record<K, number>;
+  evaluateMany<K extends string>(
+    expressions: Record<K, string | XPathExpression>,
+    options: EvaluateManyOptions & { as: 'nodes' }
+  ): Record<K, Node[] | string | number | boolean>;
   node(name: string, content?: string): Element;
+  /**
+   * Build the lookup table for the given attribute(s), "id" by default.
+   * Tables are kept up to date as the document is modified.
+   */
+  buildIndex(options?: { attribute?: string | string[] }): this;
+  /**
+   * The first element, in document order, whose attribute has the value.
+   */
+  lookup(attribute: string, value: string): Element | null;
+  getElementById(id: string): Element | null;
+  /**
+   * Elements with the given local name in document order, from an index
+   * built on first use. nsUri restricts the namespace, null meaning none.
+   */
+  getElementsByTagName(name: string, nsUri?: string | null): Element[];
+  toObject(options?: ToObjectOptions): ObjectValue;
+  /**
+   * Export the tree as typed arrays in one native pass, without wrappers.
+   * Attributes and the DTD are not included.
+   */
+  toFlatTree(): FlatTree;
+  /**
+   * CSS selectors, matched natively. Type and attribute names are lower
+   * cased for html documents.
+   */
+  querySelector(selector: string): Element | null;
+  querySelectorAll(selector: string): Element[];
+  /**
+   * A cursor on the document node, for walking the tree without creating
+   * node objects.
+   */
+  cursor(): Cursor;
+  /**
+   * Free the document right away instead of when it is garbage
+   * collected. Its nodes, including removed ones, can't be used anymore
+   * afterwards. Documents that are being validated in the background
+   * can't be disposed.
+   */
+  dispose(): void;
+  /**
+   * Register namespace prefixes once for find() and get() on any node of
+   * the document. A null href removes a prefix.
+   */
+  registerXPathNamespaces(namespaces: {
+    [prefix: string]: string | null;
+  }): this;
   root(): Element | null;
   root(newRoot: Node): Node;
   toString(formatted?: boolean): string;
   type(): 'document';
-  validate(xsdDoc: Document): boolean;
-  schematronValidate(schemaDoc: Document): boolean;
+  validate(xsdDoc: Document | Schema): boolean;
+  rngValidate(rngDoc: Document | RelaxNGSchema): boolean;
+  schematronValidate(schemaDoc: Document | SchematronSchema): boolean;
+  validateAsync(xsdDoc: Document | Schema): Promise<ValidationResult>;
+  rngValidateAsync(rngDoc: Document | RelaxNGSchema): Promise<ValidationResult>;
+  schematronValidateAsync(
+    schemaDoc: Document | SchematronSchema
+  ): Promise<ValidationResult>;
   version(): string;
   setDtd(name: string, ext: string, sys: string): void;
   getDtd(): {
@@ -144,6 +357,21 @@ export class Node {
   ): string;
 }
 
+export interface ToObjectOptions {
+  /** prepended to attribute names, "@" by default */
+  attributePrefix?: string;
+  /** key of the text of elements with attributes or children, "#text" */
+  textKey?: string;
+  /** child elements to always collect into arrays, all of them when true */
+  alwaysArray?: boolean | string[];
+  /** namespaced names as "prefix:name" (default), "name" or "{uri}name" */
+  namespaces?: 'prefix' | 'local' | 'uri';
+}
+
+export type ObjectValue =
+  | string
+  | { [key: string]: ObjectValue | ObjectValue[] };
+
 export class Element extends Node {
   constructor(doc: Document, name: string, content?: string);
   node(name: string, content?: string): Element;
@@ -155,6 +383,24 @@ export class Element extends Node {
   attr(name: string, value: string): this; //setter
   attr(attrObject: StringMap): this; //setter using stringMap
   attrs(): Attribute[];
+  /**
+   * All attribute values by (prefixed) name, without Attribute wrappers.
+   */
+  attrsObject(): StringMap;
+  /**
+   * Set many attributes in one native call, the same as attr(attrObject).
+   */
+  setAttributes(attributes: StringMap): this;
+  getAttribute(name: string): string | null;
+  /**
+   * Convert the subtree to plain objects in one native pass. Elements with
+   * neither attributes nor child elements become their text.
+   */
+  toObject(options?: ToObjectOptions): ObjectValue;
+  /**
+   * Add the elements, attributes and text described by the object.
+   */
+  appendObject(obj: object, options?: FromObjectOptions): this;
   cdata(data: string): this;
 
   doc(): Document;
@@ -171,10 +417,86 @@ export class Element extends Node {
   addNextSibling<T extends Node>(siblingNode: T): T;
   addPrevSibling<T extends Node>(siblingNode: T): T;
 
-  find<T extends Node = Node>(xpath: string, ns_uri?: string): T[];
-  find<T extends Node = Node>(xpath: string, namespaces: StringMap): T[];
-  get<T extends Node = Node>(xpath: string, ns_uri?: string): T | null;
-  get<T extends Node = Node>(xpath: string, namespaces: StringMap): T | null;
+  find<T extends Node = Node>(
+    xpath: string | XPathExpression,
+    ns_uri?: string,
+    variables?: XPathVariables
+  ): T[];
+  find<T extends Node = Node>(
+    xpath: string | XPathExpression,
+    namespaces: StringMap,
+    variables?: XPathVariables
+  ): T[];
+  get<T extends Node = Node>(
+    xpath: string | XPathExpression,
+    ns_uri?: string,
+    variables?: XPathVariables
+  ): T | null;
+  get<T extends Node = Node>(
+    xpath: string | XPathExpression,
+    namespaces: StringMap,
+    variables?: XPathVariables
+  ): T | null;
+  /**
+   * The string-value of every matching node, no node wrappers are created.
+   */
+  findStrings(
+    xpath: string | XPathExpression,
+    namespaces?: string | StringMap,
+    variables?: XPathVariables
+  ): string[];
+  /**
+   * The values of the matching attribute nodes, other nodes are skipped.
+   */
+  findAttrValues(
+    xpath: string | XPathExpression,
+    namespaces?: string | StringMap,
+    variables?: XPathVariables
+  ): string[];
+  count(
+    xpath: string | XPathExpression,
+    namespaces?: string | StringMap,
+    variables?: XPathVariables
+  ): number;
+  /**
+   * Lazily iterate over the matching nodes, wrapping each only once reached.
+   * Throws if the document is modified during the iteration.
+   */
+  iterate(
+    xpath: string | XPathExpression,
+    namespaces?: string | StringMap,
+    variables?: XPathVariables
+  ): XPathIterator;
+  evaluateMany<K extends string>(
+    expressions: Record<K, string | XPathExpression>,
+    options?: EvaluateManyOptions & { as?: 'string' }
+  ): Record<K, string>;
+  evaluateMany<K extends string>(
+    expressions: Record<K, string | XPathExpression>,
+    options: EvaluateManyOptions & { as: 'number' }
+  ): Record<K, number>;
+  evaluateMany<K extends string>(
+    expressions: Record<K, string | XPathExpression>,
+    options: EvaluateManyOptions & { as: 'nodes' }
+  ): Record<K, Node[] | string | number | boolean>;
+  getElementsByTagName(name: string, nsUri?: string | null): Element[];
+  querySelector(selector: string): Element | null;
+  querySelectorAll(selector: string): Element[];
+  cursor(): Cursor;
+  /**
+   * Visit this element and its descendants in document order. The cursor
+   * is shared by all calls, use cursor.node() for the node object.
+   * Returning false from the visitor skips the children of the node.
+   */
+  walk(
+    visitor: (
+      name: string | null,
+      type: number,
+      depth: number,
+      cursor: Cursor
+    ) => boolean | void,
+    options?: WalkOptions
+  ): void;
 
   defineNamespace(prefixOrHref: string, hrefInCaseOfPrefix?: string): Namespace;
 
@@ -228,6 +550,70 @@ export class ProcessingInstruction extends Node {
   text(newContent: string): this;
 }
 
+export class Schema {
+  constructor(xsdDoc: Document);
+
+  /**
+   * Warnings raised while compiling the schema
+   */
+  errors: ValidationError[];
+}
+
+export class RelaxNGSchema {
+  constructor(rngDoc: Document);
+
+  /**
+   * Warnings raised while compiling the grammar
+   */
+  errors: ValidationError[];
+}
+
+export class SchematronSchema {
+  constructor(schDoc: Document);
+
+  /**
+   * Warnings raised while compiling the schema
+   */
+  errors: ValidationError[];
+}
+
+export class XPathIterator implements IterableIterator<Node> {
+  next(): IteratorResult<Node>;
+  /**
+   * Stop iterating and release the node set.
+   */
+  return(value?: any): IteratorResult<Node>;
+  length(): number;
+  [Symbol.iterator](): XPathIterator;
+}
+
+/**
+ * A position in the tree. The move methods return false and stay put when
+ * there is no such node. Throws once the document has been modified.
+ */
+export class Cursor {
+  parent(): boolean;
+  firstChild(): boolean;
+  lastChild(): boolean;
+  nextSibling(): boolean;
+  prevSibling(): boolean;
+  firstElementChild(): boolean;
+  nextElementSibling(): boolean;
+  /** null for nodes other than elements, PIs and entity references */
+  name(): string | null;
+  type(): string;
+  text(): string | null;
+  attr(name: string): string | null;
+  /** the node object for the current position */
+  node(): Document | Node;
+}
+
+export class XPathExpression {
+  constructor(expression: string);
+
+  expression: string;
+}
+
 export class Namespace {
   href(): string;
   prefix(): string;
@@ -271,3 +657,8 @@ export interface ValidationError extends Error {
    */
   column: number;
 }
+
+export interface ValidationResult {
+  valid: boolean;
+  errors: ValidationError[];
+}
@@ -9,10 +9,16 @@ const Document = require('./lib/document');
 // / parse an xml string and return a Document
 module.exports.parseXml = Document.fromXml;
 
+// / parse an xml string or buffer on the threadpool, resolves to a Document
+module.exports.parseXmlAsync = Document.fromXmlAsync;
+
 // / parse an html string and return a Document
 module.exports.parseHtml = Document.fromHtml;
 module.exports.parseHtmlFragment = Document.fromHtmlFragment;
 
+// / parse an html string or buffer on the threadpool, resolves to a Document
+module.exports.parseHtmlAsync = Document.fromHtmlAsync;
+
 // constants
 module.exports.version = require('./package.json').version;
 module.exports.libxml_version = bindings.libxml_version;
@@ -43,3 +49,37 @@ module.exports.memoryUsage = bindings.xmlMemUsed;
 module.exports.nodeCount = bindings.xmlNodeCount;
 
 module.exports.TextWriter = bindings.TextWriter;
+
+// / compile an xsd document once, for use with Document#validate
+module.exports.Schema = bindings.Schema;
+module.exports.compileSchema = function compileSchema(xsdDoc) {
+  return new bindings.Schema(xsdDoc);
+};
+
+// / compile a RELAX NG document once, for use with Document#rngValidate
+module.exports.RelaxNGSchema = bindings.RelaxNGSchema;
+module.exports.compileRelaxNGSchema = function compileRelaxNGSchema(rngDoc) {
+  return new bindings.RelaxNGSchema(rngDoc);
+};
+
+// / compile a Schematron document once, for use with
+// / Document#schematronValidate
+module.exports.SchematronSchema = bindings.SchematronSchema;
+module.exports.compileSchematronSchema = function compileSchematronSchema(
+  schDoc
+) {
+  return new bindings.SchematronSchema(schDoc);
+};
+
+// / compile an xpath expression once, for use with Element#find and #get
+module.exports.XPathExpression = bindings.XPathExpression;
+module.exports.compileXPath = function compileXPath(expression) {
+  return new bindings.XPathExpression(expression);
+};
+
+// / size of the cache of compiled xpath expressions used by find/get
+// / given as a plain string, 0 disables the cache
+module.exports.setXPathCacheSize = bindings.xpathCacheSize;
+
+// / @return {size, capacity, hits, misses} of the xpath cache
+module.exports.xpathCacheStats = bindings.xpathCacheStats;
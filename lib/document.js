@@ -21,18 +21,67 @@ Document.prototype.node = function node(name, content) {
 
 // / xpath search
 // / @return array of matching elements
-Document.prototype.find = function find(xpath, ns_uri) {
+Document.prototype.find = function find(xpath, ns_uri, vars) {
   assertRoot(this);
 
-  return this.root().find(xpath, ns_uri);
+  return this.root().find(xpath, ns_uri, vars);
 };
 
 // / xpath search
 // / @return first element matching
-Document.prototype.get = function get(xpath, ns_uri) {
+Document.prototype.get = function get(xpath, ns_uri, vars) {
   assertRoot(this);
 
-  return this.root().get(xpath, ns_uri);
+  return this.root().get(xpath, ns_uri, vars);
+};
+
+// / xpath search without creating node wrappers
+// / @return array of the string-value of every matching node
+Document.prototype.findStrings = function findStrings(xpath, ns_uri, vars) {
+  assertRoot(this);
+
+  return this.root().findStrings(xpath, ns_uri, vars);
+};
+
+// / @return array of the values of the matching attributes
+Document.prototype.findAttrValues = function findAttrValues(
+  xpath,
+  ns_uri,
+  vars
+) {
+  assertRoot(this);
+
+  return this.root().findAttrValues(xpath, ns_uri, vars);
+};
+
+// / lazy xpath search, nodes are only wrapped once they are reached
+// / @return an iterator over the matching nodes
+Document.prototype.iterate = function iterate(xpath, ns_uri, vars) {
+  assertRoot(this);
+
+  return this.root().iterate(xpath, ns_uri, vars);
+};
+
+// / @return number of matching nodes
+Document.prototype.count = function count(xpath, ns_uri, vars) {
+  assertRoot(this);
+
+  return this.root().count(xpath, ns_uri, vars);
+};
+
+// / evaluate many xpath expressions against the root in one call
+// / @return an object with the result of each expression
+Document.prototype.evaluateMany = function evaluateMany(expressions, options) {
+  assertRoot(this);
+
+  return this.root().evaluateMany(expressions, options);
+};
+
+// / convert the root element to plain objects, see Element#toObject
+Document.prototype.toObject = function toObject(options) {
+  assertRoot(this);
+
+  return this.root().toObject(options);
 };
 
 // / @return a given child
@@ -72,6 +121,42 @@ Document.prototype.setDtd = function setDtd(name, ext, sys) {
   return this._setDtd(...params);
 };
 
+function runValidation(doc, method, schema) {
+  return new Promise((resolve, reject) => {
+    doc[method](schema, (err, result) => {
+      if (err) {
+        reject(err);
+      } else {
+        resolve(result);
+      }
+    });
+  });
+}
+
+// / validate against a xsd schema, off the main thread
+// / the document cannot be modified until the returned promise has settled
+// / @param schema a Document or compiled Schema
+// / @return a Promise for {valid:boolean, errors:Array}
+Document.prototype.validateAsync = function validateAsync(schema) {
+  return runValidation(this, '_validateAsync', schema);
+};
+
+// / validate against a RELAX NG schema, off the main thread
+// / @param schema a Document or compiled RelaxNGSchema
+// / @return a Promise for {valid:boolean, errors:Array}
+Document.prototype.rngValidateAsync = function rngValidateAsync(schema) {
+  return runValidation(this, '_rngValidateAsync', schema);
+};
+
+// / validate against a Schematron schema, off the main thread
+// / @param schema a Document or compiled SchematronSchema
+// / @return a Promise for {valid:boolean, errors:Array}
+Document.prototype.schematronValidateAsync = function schematronValidateAsync(
+  schema
+) {
+  return runValidation(this, '_schematronValidateAsync', schema);
+};
+
 // / @return array of namespaces in document
 Document.prototype.namespaces = function namespaces() {
   assertRoot(this);
@@ -94,6 +179,28 @@ module.exports.fromHtml = function fromHtml(string, opts = {}) {
   return bindings.fromHtml(string, opts);
 };
 
+// / parse a string or buffer into a html document, off the main thread
+// / a buffer must not be modified until the returned promise has settled
+// / @param string html string or buffer to parse
+// / @param {encoding:string, baseUrl:string} opts html string to parse
+// / @return a Promise for a Document
+module.exports.fromHtmlAsync = function fromHtmlAsync(string, opts = {}) {
+  return new Promise((resolve, reject) => {
+    // if for some reason user did not specify an object for the options
+    if (typeof opts !== 'object') {
+      throw new Error('fromHtmlAsync options must be an object');
+    }
+
+    bindings.fromHtmlAsync(string, opts, (err, doc) => {
+      if (err) {
+        reject(err);
+      } else {
+        resolve(doc);
+      }
+    });
+  });
+};
+
 // / parse a string into a html document fragment
 // / @param string html string to parse
 // / @param {encoding:string, baseUrl:string} opts html string to parse
@@ -116,3 +223,27 @@ module.exports.fromHtmlFragment = function fromHtmlFragment(string, opts = {}) {
 module.exports.fromXml = function fromXml(string, options = {}) {
   return bindings.fromXml(string, options);
 };
+
+// / build a document from plain objects in one native call
+// / @param obj {rootName: content}, in the shape returned by toObject
+// / @param {attributePrefix:string, textKey:string} options
+// / @return a Document
+module.exports.fromObject = function fromObject(obj, options = {}) {
+  return bindings.fromObject(obj, options);
+};
+
+// / parse a string or buffer into a xml document, off the main thread
+// / a buffer must not be modified until the returned promise has settled
+// / @param string xml string or buffer to parse
+// / @return a Promise for a Document
+module.exports.fromXmlAsync = function fromXmlAsync(string, options = {}) {
+  return new Promise((resolve, reject) => {
+    bindings.fromXmlAsync(string, options, (err, doc) => {
+      if (err) {
+        reject(err);
+      } else {
+        resolve(doc);
+      }
+    });
+  });
+};
@@ -27,12 +27,7 @@ Element.prototype.attr = function attr(...args) {
 
     if (typeof arg === 'object') {
       // object setter
-      // iterate keys/value to set attributes
-      for (const k in arg) {
-        this._attr(k, arg[k]);
-      }
-
-      return this;
+      return this.setAttributes(arg);
     } else if (typeof arg === 'string') {
       // getter
       return this._attr(arg);
@@ -69,6 +64,11 @@ Element.prototype.get = function get(...args) {
   return res;
 };
 
+// / xpath results of iterate() are iterable, e.g. with for...of
+bindings.XPathIterator.prototype[Symbol.iterator] = function iterator() {
+  return this;
+};
+
 Element.prototype.defineNamespace = function defineNamespace(prefix, href) {
   // if no prefix specified
   if (!href) {
@@ -2,14 +2,23 @@
 
 #include <v8.h>
 
+#include <atomic>
+
 #include <libxml/xmlmemory.h>
 
 #include "libxmljs.h"
+#include "xml_cursor.h"
 #include "xml_document.h"
 #include "xml_namespace.h"
 #include "xml_node.h"
+#include "xml_relaxng_schema.h"
 #include "xml_sax_parser.h"
+#include "xml_schema.h"
+#include "xml_schematron_schema.h"
 #include "xml_textwriter.h"
+#include "xml_xpath_context.h"
+#include "xml_xpath_expression.h"
+#include "xml_xpath_iterator.h"
 
 using namespace v8;
 namespace libxmljs {
@@ -25,17 +34,32 @@ int xml_memory_used = 0;
 const int nan_adjust_external_memory_threshold = 1024 * 1024;
 
 // track how many nodes haven't been freed
-int nodeCount = 0;
+// (nodes are also created and freed on libuv worker threads)
+std::atomic<int> nodeCount(0);
+
+// report changes in libxml2's memory usage larger than threshold to v8
+void reportExternalMemory(int threshold) {
+  // libxml also allocates on libuv worker threads (async parsing), where
+  // there is no isolate to report to; the difference is picked up by the
+  // next allocation made on the main thread instead
+  if (Isolate::GetCurrent() == 0) {
+    return;
+  }
 
-void adjustExternalMemory() {
   const int diff = xmlMemUsed() - xml_memory_used;
 
-  if (abs(diff) > nan_adjust_external_memory_threshold) {
+  if (abs(diff) > threshold) {
     xml_memory_used += diff;
     Nan::AdjustExternalMemory(diff);
   }
 }
 
+void adjustExternalMemory() {
+  reportExternalMemory(nan_adjust_external_memory_threshold);
+}
+
+void syncExternalMemory() { reportExternalMemory(0); }
+
 // wrapper for xmlMemMalloc to update v8's knowledge of memory used
 // the GC relies on this information
 void *xmlMemMallocWrap(size_t size) {
@@ -137,7 +161,9 @@ void deregisterNodeNamespaces(xmlNode *xml_obj) {
 void xmlDeregisterNodeCallback(xmlNode *xml_obj) {
   nodeCount--;
   deregisterNodeNamespaces(xml_obj);
+  XmlDocument::NodeFreed(xml_obj);
   if (xml_obj->_private != NULL) {
+    XmlNode::free_wrapped(xml_obj);
     static_cast<XmlNode *>(xml_obj->_private)->xml_obj = NULL;
     xml_obj->_private = NULL;
   }
@@ -154,6 +180,11 @@ LibXMLJS::LibXMLJS() {
   // set the callback for when a node is about to be freed
   xmlDeregisterNodeDefault(xmlDeregisterNodeCallback);
 
+  // the callbacks above only apply to the current thread, make sure
+  // nodes created and freed on worker threads are tracked as well
+  xmlThrDefRegisterNodeDefault(xmlRegisterNodeCallback);
+  xmlThrDefDeregisterNodeDefault(xmlDeregisterNodeCallback);
+
   // populated debugMemSize (see xmlmemory.h/c) and makes the call to
   // xmlMemUsed work, this must happen first!
   xmlMemSetup(xmlMemFreeWrap, xmlMemMallocWrap, xmlMemReallocWrap,
@@ -218,13 +249,20 @@ NAN_METHOD(XmlMemUsed) {
 
 NAN_METHOD(XmlNodeCount) {
   Nan::HandleScope scope;
-  return info.GetReturnValue().Set(Nan::New<Int32>(nodeCount));
+  return info.GetReturnValue().Set(Nan::New<Int32>(nodeCount.load()));
 }
 
 NAN_MODULE_INIT(init) {
   Nan::HandleScope scope;
 
   XmlDocument::Initialize(target);
+  XmlSchema::Initialize(target);
+  XmlRelaxNGSchema::Initialize(target);
+  XmlSchematronSchema::Initialize(target);
+  XmlXPathExpression::Initialize(target);
+  XmlXpathContext::Initialize(target);
+  XmlXPathIterator::Initialize(target);
+  XmlCursor::Initialize(target);
   XmlSaxParser::Initialize(target);
   XmlTextWriter::Initialize(target);
 
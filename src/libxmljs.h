@@ -28,6 +28,26 @@
            ->HasInstance(doc)) {                                               \
     Nan::ThrowError("document argument must be an instance of Document");      \
     return;                                                                    \
+  }                                                                            \
+  if (Nan::ObjectWrap::Unwrap<XmlDocument>(doc)->xml_obj == NULL) {            \
+    Nan::ThrowError("Document has been disposed");                             \
+    return;                                                                    \
+  }
+
+#define DOCUMENT_MUTATION_CHECK(xml_doc)                                       \
+  if (XmlDocument::ModifyError(xml_doc) != NULL) {                             \
+    return Nan::ThrowError(XmlDocument::ModifyError(xml_doc));                 \
+  }
+
+// the libxml object of a wrapper is gone once its document was disposed
+#define DOCUMENT_DISPOSED_CHECK(document)                                      \
+  if ((document)->xml_obj == NULL) {                                           \
+    return Nan::ThrowError("Document has been disposed");                      \
+  }
+
+#define NODE_DISPOSED_CHECK(node)                                              \
+  if ((node)->xml_obj == NULL) {                                               \
+    return Nan::ThrowError("Node has been freed");                             \
   }
 
 namespace libxmljs {
@@ -38,6 +58,10 @@ static const bool debugging = true;
 static const bool debugging = false;
 #endif
 
+// report libxml2's memory usage to v8 right away, rather than waiting
+// for the change to exceed the usual reporting threshold
+void syncExternalMemory();
+
 // Ensure that libxml is properly initialised and destructed at shutdown
 class LibXMLJS {
 public:
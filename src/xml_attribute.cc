@@ -1,5 +1,6 @@
 // Copyright 2009, Squish Tech, LLC.
 #include "xml_attribute.h"
+#include "xml_document.h"
 
 using namespace v8;
 namespace libxmljs {
@@ -52,6 +53,7 @@ NAN_METHOD(XmlAttribute::Name) {
   Nan::HandleScope scope;
   XmlAttribute *attr = Nan::ObjectWrap::Unwrap<XmlAttribute>(info.This());
   assert(attr);
+  NODE_DISPOSED_CHECK(attr)
 
   return info.GetReturnValue().Set(attr->get_name());
 }
@@ -60,9 +62,11 @@ NAN_METHOD(XmlAttribute::Value) {
   Nan::HandleScope scope;
   XmlAttribute *attr = Nan::ObjectWrap::Unwrap<XmlAttribute>(info.This());
   assert(attr);
+  NODE_DISPOSED_CHECK(attr)
 
   // attr.value('new value');
   if (info.Length() > 0) {
+    DOCUMENT_MUTATION_CHECK(attr->xml_obj->doc)
     attr->set_value(*Nan::Utf8String(info[0]));
     return info.GetReturnValue().Set(info.This());
   }
@@ -75,6 +79,7 @@ NAN_METHOD(XmlAttribute::Node) {
   Nan::HandleScope scope;
   XmlAttribute *attr = Nan::ObjectWrap::Unwrap<XmlAttribute>(info.This());
   assert(attr);
+  NODE_DISPOSED_CHECK(attr)
 
   return info.GetReturnValue().Set(attr->get_element());
 }
@@ -83,6 +88,7 @@ NAN_METHOD(XmlAttribute::Namespace) {
   Nan::HandleScope scope;
   XmlAttribute *attr = Nan::ObjectWrap::Unwrap<XmlAttribute>(info.This());
   assert(attr);
+  NODE_DISPOSED_CHECK(attr)
 
   return info.GetReturnValue().Set(attr->get_namespace());
 }
@@ -98,8 +104,22 @@ Local<Value> XmlAttribute::get_name() {
 }
 
 Local<Value> XmlAttribute::get_value() {
+  return value_of(reinterpret_cast<xmlAttr *>(xml_obj));
+}
+
+Local<Value> XmlAttribute::value_of(xmlAttr *attr) {
   Nan::EscapableHandleScope scope;
-  xmlChar *value = xmlNodeGetContent(xml_obj);
+
+  // most values are a single text node that can be read in place
+  xmlNode *text = attr->children;
+  if ((text != NULL) && (text->next == NULL) &&
+      (text->type == XML_TEXT_NODE)) {
+    return scope.Escape(Nan::New<String>((const char *)text->content,
+                                         xmlStrlen(text->content))
+                            .ToLocalChecked());
+  }
+
+  xmlChar *value = xmlNodeGetContent(reinterpret_cast<xmlNode *>(attr));
   if (value != NULL) {
     Local<String> ret_value =
         Nan::New<String>((const char *)value, xmlStrlen(value))
@@ -139,6 +159,10 @@ void XmlAttribute::set_value(const char *value) {
     // Free up memory
     xmlFree(buffer);
   }
+  XmlDocument::TreeChanged(xml_obj->doc);
+  if (xml_obj->parent != NULL) {
+    XmlDocument::AttributesChanged(xml_obj->parent);
+  }
 }
 
 Local<Value> XmlAttribute::get_element() {
@@ -151,7 +175,7 @@ Local<Value> XmlAttribute::get_namespace() {
   if (!xml_obj->ns) {
     return scope.Escape(Nan::Null());
   }
-  return scope.Escape(XmlNamespace::New(xml_obj->ns));
+  return scope.Escape(XmlNamespace::New(xml_obj->ns, this));
 }
 
 void XmlAttribute::Initialize(Local<Object> target) {
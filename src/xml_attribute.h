@@ -21,6 +21,9 @@ public:
 
   static v8::Local<v8::Object> New(xmlAttr *attr);
 
+  // the value of the attribute as a string, without creating a wrapper
+  static v8::Local<v8::Value> value_of(xmlAttr *attr);
+
 protected:
   static NAN_METHOD(New);
   static NAN_METHOD(Name);
@@ -30,6 +30,7 @@ NAN_METHOD(XmlComment::New) {
 
   XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(doc);
   assert(document);
+  DOCUMENT_MUTATION_CHECK(document->xml_obj)
 
   Local<Value> contentOpt;
   if (info[1]->IsString()) {
@@ -56,10 +57,12 @@ NAN_METHOD(XmlComment::Text) {
   Nan::HandleScope scope;
   XmlComment *comment = Nan::ObjectWrap::Unwrap<XmlComment>(info.This());
   assert(comment);
+  NODE_DISPOSED_CHECK(comment)
 
   if (info.Length() == 0) {
     return info.GetReturnValue().Set(comment->get_content());
   } else {
+    DOCUMENT_MUTATION_CHECK(comment->xml_obj->doc)
     comment->set_content(*Nan::Utf8String(info[0]));
   }
 
@@ -68,6 +71,7 @@ NAN_METHOD(XmlComment::Text) {
 
 void XmlComment::set_content(const char *content) {
   xmlNodeSetContent(xml_obj, (xmlChar *)content);
+  XmlDocument::TreeChanged(xml_obj->doc);
 }
 
 Local<Value> XmlComment::get_content() {
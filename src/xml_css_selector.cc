@@ -0,0 +1,804 @@
+// Copyright 2009, Squish Tech, LLC.
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "xml_css_selector.h"
+#include "xml_document.h"
+#include "xml_element.h"
+#include "xml_node_index.h"
+
+using namespace v8;
+
+namespace libxmljs {
+
+struct AttributeTest {
+  std::string name;
+  // the name to look for in html documents
+  std::string html_name;
+  // 0 when the attribute only has to be present, otherwise the first
+  // character of the operator
+  char op;
+  std::string value;
+};
+
+struct PseudoClass {
+  enum Kind {
+    ROOT,
+    EMPTY,
+    FIRST_CHILD,
+    LAST_CHILD,
+    ONLY_CHILD,
+    NTH_CHILD,
+    NTH_LAST_CHILD,
+    NOT
+  };
+  Kind kind;
+  // an+b of :nth-child() and :nth-last-child()
+  int a;
+  int b;
+  // the arguments of :not()
+  std::vector<std::shared_ptr<XmlCssSelector::Compound>> negated;
+};
+
+struct XmlCssSelector::Compound {
+  // relation to the compound before it: ' ', '>', '+' or '~'
+  char combinator;
+  // empty for any element
+  std::string tag;
+  std::string html_tag;
+  std::string id;
+  std::vector<std::string> classes;
+  std::vector<AttributeTest> attributes;
+  std::vector<PseudoClass> pseudo_classes;
+};
+
+typedef XmlCssSelector::Compound Compound;
+typedef XmlCssSelector::Complex Complex;
+
+static std::string lowerCase(const std::string &name) {
+  std::string lower(name);
+  for (char &c : lower) {
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+  }
+  return lower;
+}
+
+static bool isSpace(char c) { return isspace(static_cast<unsigned char>(c)); }
+
+static bool isNameChar(char c) {
+  unsigned char u = static_cast<unsigned char>(c);
+  return isalnum(u) || (c == '-') || (c == '_') || (u >= 0x80);
+}
+
+// recursive descent over the selector grammar
+class SelectorParser {
+public:
+  explicit SelectorParser(const std::string &source) : source(source), pos(0) {}
+
+  bool parse(std::vector<Complex> &alternatives);
+
+private:
+  bool at_end() { return pos >= source.size(); }
+  char peek() { return at_end() ? '\0' : source[pos]; }
+  bool skip_space();
+
+  bool parse_ident(std::string &ident);
+  bool parse_value(std::string &value);
+  bool parse_complex(Complex &complex);
+  bool parse_compound(Compound &compound);
+  bool parse_attribute(AttributeTest &test);
+  bool parse_pseudo_class(PseudoClass &pseudo);
+  bool parse_nth(PseudoClass &pseudo);
+
+  const std::string &source;
+  size_t pos;
+};
+
+bool SelectorParser::skip_space() {
+  size_t start = pos;
+  while (!at_end() && isSpace(source[pos])) {
+    pos++;
+  }
+  return pos != start;
+}
+
+bool SelectorParser::parse_ident(std::string &ident) {
+  ident.clear();
+  while (!at_end()) {
+    char c = source[pos];
+    if ((c == '\\') && (pos + 1 < source.size())) {
+      ident += source[pos + 1];
+      pos += 2;
+    } else if (isNameChar(c)) {
+      ident += c;
+      pos++;
+    } else {
+      break;
+    }
+  }
+  return !ident.empty();
+}
+
+// an identifier or a quoted string
+bool SelectorParser::parse_value(std::string &value) {
+  char quote = peek();
+  if ((quote != '"') && (quote != '\'')) {
+    return parse_ident(value);
+  }
+
+  value.clear();
+  for (pos++; !at_end(); pos++) {
+    char c = source[pos];
+    if (c == quote) {
+      pos++;
+      return true;
+    }
+    if ((c == '\\') && (pos + 1 < source.size())) {
+      c = source[++pos];
+    }
+    value += c;
+  }
+  return false;
+}
+
+bool SelectorParser::parse(std::vector<Complex> &alternatives) {
+  for (;;) {
+    skip_space();
+    alternatives.push_back(Complex());
+    if (!parse_complex(alternatives.back())) {
+      return false;
+    }
+    skip_space();
+    if (at_end()) {
+      return true;
+    }
+    if (peek() != ',') {
+      return false;
+    }
+    pos++;
+  }
+}
+
+bool SelectorParser::parse_complex(Complex &complex) {
+  char combinator = ' ';
+  for (;;) {
+    complex.push_back(Compound());
+    complex.back().combinator = combinator;
+    if (!parse_compound(complex.back())) {
+      return false;
+    }
+
+    bool space = skip_space();
+    char c = peek();
+    if ((c == '>') || (c == '+') || (c == '~')) {
+      combinator = c;
+      pos++;
+      skip_space();
+    } else if (space && !at_end() && (c != ',') && (c != ')')) {
+      combinator = ' ';
+    } else {
+      return true;
+    }
+  }
+}
+
+bool SelectorParser::parse_compound(Compound &compound) {
+  bool empty = true;
+  if (peek() == '*') {
+    pos++;
+    empty = false;
+  } else if (parse_ident(compound.tag)) {
+    compound.html_tag = lowerCase(compound.tag);
+    empty = false;
+  }
+
+  for (;;) {
+    char c = peek();
+    if (c == '#') {
+      pos++;
+      std::string id;
+      if (!parse_ident(id)) {
+        return false;
+      }
+      // any further id has to match as well
+      if (compound.id.empty()) {
+        compound.id = id;
+      } else {
+        compound.attributes.push_back(AttributeTest{"id", "id", '=', id});
+      }
+    } else if (c == '.') {
+      pos++;
+      compound.classes.push_back(std::string());
+      if (!parse_ident(compound.classes.back())) {
+        return false;
+      }
+    } else if (c == '[') {
+      pos++;
+      compound.attributes.push_back(AttributeTest());
+      if (!parse_attribute(compound.attributes.back())) {
+        return false;
+      }
+    } else if (c == ':') {
+      pos++;
+      compound.pseudo_classes.push_back(PseudoClass());
+      if (!parse_pseudo_class(compound.pseudo_classes.back())) {
+        return false;
+      }
+    } else {
+      break;
+    }
+    empty = false;
+  }
+
+  return !empty;
+}
+
+// [name], [name=value], [name~=value] etc, after the opening bracket
+bool SelectorParser::parse_attribute(AttributeTest &test) {
+  skip_space();
+  if (!parse_ident(test.name)) {
+    return false;
+  }
+  test.html_name = lowerCase(test.name);
+  skip_space();
+
+  test.op = 0;
+  char c = peek();
+  if (c == '=') {
+    test.op = c;
+    pos++;
+  } else if ((c == '~') || (c == '|') || (c == '^') || (c == '$') ||
+             (c == '*')) {
+    if ((pos + 1 >= source.size()) || (source[pos + 1] != '=')) {
+      return false;
+    }
+    test.op = c;
+    pos += 2;
+  }
+
+  if (test.op != 0) {
+    skip_space();
+    if (!parse_value(test.value)) {
+      return false;
+    }
+    skip_space();
+  }
+
+  if (peek() != ']') {
+    return false;
+  }
+  pos++;
+  return true;
+}
+
+// after the colon
+bool SelectorParser::parse_pseudo_class(PseudoClass &pseudo) {
+  std::string name;
+  if (!parse_ident(name)) {
+    return false;
+  }
+  name = lowerCase(name);
+
+  if (name == "root") {
+    pseudo.kind = PseudoClass::ROOT;
+  } else if (name == "empty") {
+    pseudo.kind = PseudoClass::EMPTY;
+  } else if (name == "first-child") {
+    pseudo.kind = PseudoClass::FIRST_CHILD;
+  } else if (name == "last-child") {
+    pseudo.kind = PseudoClass::LAST_CHILD;
+  } else if (name == "only-child") {
+    pseudo.kind = PseudoClass::ONLY_CHILD;
+  } else if ((name == "nth-child") || (name == "nth-last-child")) {
+    pseudo.kind = (name == "nth-child") ? PseudoClass::NTH_CHILD
+                                        : PseudoClass::NTH_LAST_CHILD;
+    if (peek() != '(') {
+      return false;
+    }
+    pos++;
+    return parse_nth(pseudo);
+  } else if (name == "not") {
+    pseudo.kind = PseudoClass::NOT;
+    if (peek() != '(') {
+      return false;
+    }
+    pos++;
+    for (;;) {
+      skip_space();
+      std::shared_ptr<Compound> negated = std::make_shared<Compound>();
+      negated->combinator = ' ';
+      if (!parse_compound(*negated)) {
+        return false;
+      }
+      pseudo.negated.push_back(negated);
+      skip_space();
+      if (peek() != ',') {
+        break;
+      }
+      pos++;
+    }
+    if (peek() != ')') {
+      return false;
+    }
+    pos++;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool parseInteger(const std::string &text, int &value) {
+  if (text.empty()) {
+    return false;
+  }
+  char *end;
+  value = static_cast<int>(strtol(text.c_str(), &end, 10));
+  return *end == '\0';
+}
+
+// odd, even, b, an or an+b up to the closing parenthesis
+bool SelectorParser::parse_nth(PseudoClass &pseudo) {
+  size_t close = source.find(')', pos);
+  if (close == std::string::npos) {
+    return false;
+  }
+
+  std::string arg;
+  for (size_t i = pos; i < close; i++) {
+    if (!isSpace(source[i])) {
+      arg += static_cast<char>(tolower(static_cast<unsigned char>(source[i])));
+    }
+  }
+  pos = close + 1;
+
+  if (arg == "odd") {
+    pseudo.a = 2;
+    pseudo.b = 1;
+    return true;
+  }
+  if (arg == "even") {
+    pseudo.a = 2;
+    pseudo.b = 0;
+    return true;
+  }
+
+  size_t n = arg.find('n');
+  if (n == std::string::npos) {
+    pseudo.a = 0;
+    return parseInteger(arg, pseudo.b);
+  }
+
+  std::string a = arg.substr(0, n);
+  std::string b = arg.substr(n + 1);
+  if (a.empty() || (a == "+")) {
+    pseudo.a = 1;
+  } else if (a == "-") {
+    pseudo.a = -1;
+  } else if (!parseInteger(a, pseudo.a)) {
+    return false;
+  }
+
+  pseudo.b = 0;
+  if (b.empty()) {
+    return true;
+  }
+  return ((b[0] == '+') || (b[0] == '-')) && parseInteger(b, pseudo.b);
+}
+
+// the value of the attribute, `buffer` holds it unless it could be
+// used in place
+static const char *attributeValue(xmlAttr *attr, std::string &buffer) {
+  xmlNode *text = attr->children;
+  if (text == NULL) {
+    return "";
+  }
+  if ((text->next == NULL) && (text->type == XML_TEXT_NODE)) {
+    return reinterpret_cast<const char *>(text->content);
+  }
+
+  xmlChar *value = xmlNodeGetContent(reinterpret_cast<xmlNode *>(attr));
+  buffer = value ? reinterpret_cast<const char *>(value) : "";
+  xmlFree(value);
+  return buffer.c_str();
+}
+
+// selectors without a namespace only match attributes without one
+static xmlAttr *findAttribute(xmlNode *element, const std::string &name) {
+  for (xmlAttr *attr = element->properties; attr != NULL; attr = attr->next) {
+    if ((attr->ns == NULL) &&
+        xmlStrEqual(attr->name,
+                    reinterpret_cast<const xmlChar *>(name.c_str()))) {
+      return attr;
+    }
+  }
+  return NULL;
+}
+
+// whether the whitespace separated list contains the token
+static bool hasToken(const char *list, const std::string &token) {
+  if (token.empty()) {
+    return false;
+  }
+  const char *c = list;
+  while (*c != '\0') {
+    while ((*c != '\0') && isSpace(*c)) {
+      c++;
+    }
+    const char *start = c;
+    while ((*c != '\0') && !isSpace(*c)) {
+      c++;
+    }
+    if ((static_cast<size_t>(c - start) == token.size()) &&
+        (strncmp(start, token.c_str(), token.size()) == 0)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool attributeMatches(xmlNode *element, const AttributeTest &test,
+                             bool html) {
+  xmlAttr *attr = findAttribute(element, html ? test.html_name : test.name);
+  if (attr == NULL) {
+    return false;
+  }
+  if (test.op == 0) {
+    return true;
+  }
+
+  std::string buffer;
+  const char *value = attributeValue(attr, buffer);
+  size_t length = strlen(value);
+  const std::string &wanted = test.value;
+
+  switch (test.op) {
+  case '=':
+    return wanted == value;
+  case '~':
+    return hasToken(value, wanted);
+  case '|':
+    return (wanted == value) ||
+           ((length > wanted.size()) && (value[wanted.size()] == '-') &&
+            (strncmp(value, wanted.c_str(), wanted.size()) == 0));
+  case '^':
+    return !wanted.empty() &&
+           (strncmp(value, wanted.c_str(), wanted.size()) == 0);
+  case '$':
+    return !wanted.empty() && (length >= wanted.size()) &&
+           (strcmp(value + length - wanted.size(), wanted.c_str()) == 0);
+  case '*':
+    return !wanted.empty() && (strstr(value, wanted.c_str()) != NULL);
+  default:
+    return false;
+  }
+}
+
+static xmlNode *parentElement(xmlNode *element) {
+  xmlNode *parent = element->parent;
+  return ((parent != NULL) && (parent->type == XML_ELEMENT_NODE)) ? parent
+                                                                   : NULL;
+}
+
+static xmlNode *previousElement(xmlNode *element) {
+  for (xmlNode *sibling = element->prev; sibling != NULL;
+       sibling = sibling->prev) {
+    if (sibling->type == XML_ELEMENT_NODE) {
+      return sibling;
+    }
+  }
+  return NULL;
+}
+
+// 1 based position of the element among its element siblings
+static int elementPosition(xmlNode *element, bool from_end) {
+  int position = 1;
+  for (xmlNode *sibling = from_end ? element->next : element->prev;
+       sibling != NULL; sibling = from_end ? sibling->next : sibling->prev) {
+    if (sibling->type == XML_ELEMENT_NODE) {
+      position++;
+    }
+  }
+  return position;
+}
+
+// whether position is a*n+b for some n >= 0
+static bool nthMatches(int a, int b, int position) {
+  if (a == 0) {
+    return position == b;
+  }
+  int diff = position - b;
+  return (diff % a == 0) && (diff / a >= 0);
+}
+
+static bool isEmpty(xmlNode *element) {
+  for (xmlNode *child = element->children; child != NULL;
+       child = child->next) {
+    switch (child->type) {
+    case XML_ELEMENT_NODE:
+    case XML_ENTITY_REF_NODE:
+      return false;
+    case XML_TEXT_NODE:
+    case XML_CDATA_SECTION_NODE:
+      if ((child->content != NULL) && (child->content[0] != '\0')) {
+        return false;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  return true;
+}
+
+static bool compoundMatches(const Compound &compound, xmlNode *element,
+                            bool html);
+
+static bool pseudoClassMatches(const PseudoClass &pseudo, xmlNode *element,
+                               bool html) {
+  switch (pseudo.kind) {
+  case PseudoClass::ROOT:
+    return (element->parent != NULL) &&
+           ((element->parent->type == XML_DOCUMENT_NODE) ||
+            (element->parent->type == XML_HTML_DOCUMENT_NODE));
+  case PseudoClass::EMPTY:
+    return isEmpty(element);
+  case PseudoClass::FIRST_CHILD:
+    return elementPosition(element, false) == 1;
+  case PseudoClass::LAST_CHILD:
+    return elementPosition(element, true) == 1;
+  case PseudoClass::ONLY_CHILD:
+    return (elementPosition(element, false) == 1) &&
+           (elementPosition(element, true) == 1);
+  case PseudoClass::NTH_CHILD:
+    return nthMatches(pseudo.a, pseudo.b, elementPosition(element, false));
+  case PseudoClass::NTH_LAST_CHILD:
+    return nthMatches(pseudo.a, pseudo.b, elementPosition(element, true));
+  case PseudoClass::NOT:
+    for (const std::shared_ptr<Compound> &negated : pseudo.negated) {
+      if (compoundMatches(*negated, element, html)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+static bool compoundMatches(const Compound &compound, xmlNode *element,
+                            bool html) {
+  const std::string &tag = html ? compound.html_tag : compound.tag;
+  if (!tag.empty() &&
+      !xmlStrEqual(element->name,
+                   reinterpret_cast<const xmlChar *>(tag.c_str()))) {
+    return false;
+  }
+
+  std::string buffer;
+  if (!compound.id.empty()) {
+    xmlAttr *id = findAttribute(element, "id");
+    if ((id == NULL) || (compound.id != attributeValue(id, buffer))) {
+      return false;
+    }
+  }
+
+  if (!compound.classes.empty()) {
+    xmlAttr *attr = findAttribute(element, "class");
+    if (attr == NULL) {
+      return false;
+    }
+    const char *classes = attributeValue(attr, buffer);
+    for (const std::string &name : compound.classes) {
+      if (!hasToken(classes, name)) {
+        return false;
+      }
+    }
+  }
+
+  for (const AttributeTest &test : compound.attributes) {
+    if (!attributeMatches(element, test, html)) {
+      return false;
+    }
+  }
+
+  for (const PseudoClass &pseudo : compound.pseudo_classes) {
+    if (!pseudoClassMatches(pseudo, element, html)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// match compounds [0, index] from right to left, element being the
+// candidate for complex[index]
+static bool complexMatches(const Complex &complex, size_t index,
+                           xmlNode *element, bool html) {
+  if (!compoundMatches(complex[index], element, html)) {
+    return false;
+  }
+  if (index == 0) {
+    return true;
+  }
+
+  switch (complex[index].combinator) {
+  case '>': {
+    xmlNode *parent = parentElement(element);
+    return (parent != NULL) && complexMatches(complex, index - 1, parent, html);
+  }
+  case '+': {
+    xmlNode *previous = previousElement(element);
+    return (previous != NULL) &&
+           complexMatches(complex, index - 1, previous, html);
+  }
+  case '~':
+    for (xmlNode *previous = previousElement(element); previous != NULL;
+         previous = previousElement(previous)) {
+      if (complexMatches(complex, index - 1, previous, html)) {
+        return true;
+      }
+    }
+    return false;
+  default:
+    for (xmlNode *ancestor = parentElement(element); ancestor != NULL;
+         ancestor = parentElement(ancestor)) {
+      if (complexMatches(complex, index - 1, ancestor, html)) {
+        return true;
+      }
+    }
+    return false;
+  }
+}
+
+bool XmlCssSelector::matches(xmlNode *element, bool html) {
+  for (const Complex &complex : alternatives) {
+    if (complexMatches(complex, complex.size() - 1, element, html)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool isDescendant(xmlNode *node, xmlNode *ancestor) {
+  for (node = node->parent; node != NULL; node = node->parent) {
+    if (node == ancestor) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void XmlCssSelector::select(xmlNode *scope, size_t limit,
+                            std::vector<xmlNode *> &found) {
+  xmlDoc *doc = scope->doc;
+  bool html = (doc != NULL) && (doc->type == XML_HTML_DOCUMENT_NODE);
+
+  // the indexes of the document only cover the elements in its tree
+  XmlDocument *document = NULL;
+  if ((doc != NULL) && (doc->_private != NULL) &&
+      ((scope == reinterpret_cast<xmlNode *>(doc)) ||
+       isDescendant(scope, reinterpret_cast<xmlNode *>(doc)))) {
+    document = static_cast<XmlDocument *>(doc->_private);
+  }
+
+  if ((document != NULL) && (alternatives.size() == 1)) {
+    const Complex &complex = alternatives[0];
+    const Compound &subject = complex.back();
+
+    // only elements with the id can match, ids may be duplicated
+    if (!subject.id.empty()) {
+      std::vector<xmlNode *> candidates;
+      document->index()->find_attribute("id", subject.id, candidates);
+      for (xmlNode *element : candidates) {
+        if (isDescendant(element, scope) &&
+            complexMatches(complex, complex.size() - 1, element, html)) {
+          found.push_back(element);
+          if (found.size() == limit) {
+            return;
+          }
+        }
+      }
+      return;
+    } else if (!subject.tag.empty()) {
+      // only elements with the right name can match
+      std::vector<xmlNode *> candidates;
+      document->index()->find_elements(
+          reinterpret_cast<const xmlChar *>(
+              (html ? subject.html_tag : subject.tag).c_str()),
+          (scope->type == XML_ELEMENT_NODE) ? scope : NULL, true, NULL,
+          document->generation, candidates);
+      for (xmlNode *element : candidates) {
+        if (complexMatches(complex, complex.size() - 1, element, html)) {
+          found.push_back(element);
+          if (found.size() == limit) {
+            return;
+          }
+        }
+      }
+      return;
+    }
+  }
+
+  for (xmlNode *element = nextElement(scope, scope); element != NULL;
+       element = nextElement(element, scope)) {
+    if (matches(element, html)) {
+      found.push_back(element);
+      if (found.size() == limit) {
+        return;
+      }
+    }
+  }
+}
+
+// Compiled selectors, most recently used first
+typedef std::pair<std::string, std::unique_ptr<XmlCssSelector>>
+    CompiledSelector;
+typedef std::list<CompiledSelector> CompiledSelectorList;
+
+static CompiledSelectorList selector_cache;
+static std::unordered_map<std::string, CompiledSelectorList::iterator>
+    selector_cache_index;
+static const size_t selector_cache_capacity = 256;
+
+XmlCssSelector *XmlCssSelector::compile(const std::string &selector,
+                                        std::string &error) {
+  std::unordered_map<std::string, CompiledSelectorList::iterator>::iterator
+      found = selector_cache_index.find(selector);
+  if (found != selector_cache_index.end()) {
+    selector_cache.splice(selector_cache.begin(), selector_cache,
+                          found->second);
+    return found->second->second.get();
+  }
+
+  std::unique_ptr<XmlCssSelector> compiled(new XmlCssSelector());
+  SelectorParser parser(selector);
+  if (!parser.parse(compiled->alternatives)) {
+    error = "Invalid selector: " + selector;
+    return NULL;
+  }
+
+  selector_cache.emplace_front(selector, std::move(compiled));
+  selector_cache_index[selector] = selector_cache.begin();
+  while (selector_cache.size() > selector_cache_capacity) {
+    selector_cache_index.erase(selector_cache.back().first);
+    selector_cache.pop_back();
+  }
+  return selector_cache.front().second.get();
+}
+
+void XmlCssSelector::query(const Nan::FunctionCallbackInfo<Value> &info,
+                           xmlNode *scope, bool all) {
+  Nan::HandleScope scope_handles;
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsString,
+                               "Bad argument: selector must be a string");
+
+  std::string error;
+  XmlCssSelector *selector = compile(*Nan::Utf8String(info[0]), error);
+  if (selector == NULL) {
+    return Nan::ThrowError(error.c_str());
+  }
+
+  std::vector<xmlNode *> found;
+  selector->select(scope, all ? 0 : 1, found);
+
+  if (!all) {
+    if (found.empty()) {
+      return info.GetReturnValue().Set(Nan::Null());
+    }
+    return info.GetReturnValue().Set(XmlElement::New(found[0]));
+  }
+
+  Local<Array> elements = Nan::New<Array>(static_cast<int>(found.size()));
+  for (size_t i = 0; i < found.size(); i++) {
+    Nan::Set(elements, i, XmlElement::New(found[i]));
+  }
+  return info.GetReturnValue().Set(elements);
+}
+
+} // namespace libxmljs
@@ -0,0 +1,48 @@
+// Copyright 2009, Squish Tech, LLC.
+#ifndef SRC_XML_CSS_SELECTOR_H_
+#define SRC_XML_CSS_SELECTOR_H_
+
+#include <libxml/tree.h>
+
+#include <string>
+#include <vector>
+
+#include "libxmljs.h"
+
+namespace libxmljs {
+
+// A compiled CSS selector, matched by walking the tree directly.
+// Supports type, universal, #id, .class and [attribute] selectors
+// (=, ~=, |=, ^=, $=, *=), the descendant, child (>), adjacent (+) and
+// sibling (~) combinators, selector lists and the :root, :empty,
+// :first-child, :last-child, :only-child, :nth-child(),
+// :nth-last-child() and :not() pseudo-classes. Names are case
+// sensitive, except that html documents match them in lower case.
+class XmlCssSelector {
+public:
+  // look the selector up in the cache of compiled selectors, compiling
+  // it on a miss. Returns NULL with `error` set for invalid selectors.
+  static XmlCssSelector *compile(const std::string &selector,
+                                 std::string &error);
+
+  // the elements below `scope` (an element or document node) matching
+  // the selector in document order, at most `limit` unless it is 0
+  void select(xmlNode *scope, size_t limit, std::vector<xmlNode *> &found);
+
+  bool matches(xmlNode *element, bool html);
+
+  // querySelector(selector) and querySelectorAll(selector) of `scope`
+  static void query(const Nan::FunctionCallbackInfo<v8::Value> &info,
+                    xmlNode *scope, bool all);
+
+  struct Compound;
+  typedef std::vector<Compound> Complex;
+
+  // the comma separated selectors, each a list of compound selectors
+  // from left to right
+  std::vector<Complex> alternatives;
+};
+
+} // namespace libxmljs
+
+#endif // SRC_XML_CSS_SELECTOR_H_
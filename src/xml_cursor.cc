@@ -0,0 +1,293 @@
+// Copyright 2009, Squish Tech, LLC.
+
+#include "xml_cursor.h"
+#include "xml_element.h"
+#include "xml_node.h"
+
+using namespace v8;
+
+namespace libxmljs {
+
+Nan::Persistent<FunctionTemplate> XmlCursor::constructor_template;
+
+// only created from c++ space, see XmlCursor::New
+NAN_METHOD(XmlCursor::New) {
+  NAN_CONSTRUCTOR_CHECK(Cursor)
+  Nan::HandleScope scope;
+
+  return info.GetReturnValue().Set(info.This());
+}
+
+Local<Object> XmlCursor::New(xmlNode *node, XmlDocument *document,
+                             Local<Object> context) {
+  Nan::EscapableHandleScope scope;
+
+  XmlCursor *cursor = new XmlCursor(node, document);
+  Local<Object> obj =
+      Nan::NewInstance(
+          Nan::GetFunction(Nan::New(constructor_template)).ToLocalChecked())
+          .ToLocalChecked();
+  cursor->Wrap(obj);
+
+  // this keeps the tree the cursor points into alive
+  Nan::Set(obj, Nan::New<String>("context").ToLocalChecked(), context)
+      .Check();
+
+  return scope.Escape(obj);
+}
+
+XmlCursor::XmlCursor(xmlNode *node, XmlDocument *document)
+    : xml_obj(node), document(document) {
+  generation = (document != NULL) ? document->generation : 0;
+  if (document != NULL) {
+    document->Ref();
+  }
+}
+
+XmlCursor::~XmlCursor() {
+  if (document != NULL) {
+    document->Unref();
+  }
+}
+
+XmlCursor *XmlCursor::Unwrap(const Nan::FunctionCallbackInfo<Value> &info) {
+  XmlCursor *cursor = Nan::ObjectWrap::Unwrap<XmlCursor>(info.This());
+  assert(cursor);
+
+  if ((cursor->document != NULL) && (cursor->document->xml_obj == NULL)) {
+    Nan::ThrowError("Document has been disposed");
+    return NULL;
+  }
+
+  // the current node may have been removed or freed since
+  if ((cursor->document != NULL) &&
+      (cursor->document->generation != cursor->generation)) {
+    Nan::ThrowError("Document was modified since the cursor was created");
+    return NULL;
+  }
+  return cursor;
+}
+
+bool XmlCursor::move(xmlNode *node) {
+  if (node == NULL) {
+    return false;
+  }
+  xml_obj = node;
+  return true;
+}
+
+// the children of entity references and attributes are not part of
+// the tree the cursor walks
+static bool has_children(xmlNode *node) {
+  switch (node->type) {
+  case XML_ELEMENT_NODE:
+  case XML_DOCUMENT_NODE:
+  case XML_HTML_DOCUMENT_NODE:
+  case XML_DOCUMENT_FRAG_NODE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static xmlNode *next_element(xmlNode *node) {
+  while ((node != NULL) && (node->type != XML_ELEMENT_NODE)) {
+    node = node->next;
+  }
+  return node;
+}
+
+NAN_METHOD(XmlCursor::Parent) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  return info.GetReturnValue().Set(
+      Nan::New<Boolean>(cursor->move(cursor->xml_obj->parent)));
+}
+
+NAN_METHOD(XmlCursor::FirstChild) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  xmlNode *child =
+      has_children(cursor->xml_obj) ? cursor->xml_obj->children : NULL;
+  return info.GetReturnValue().Set(Nan::New<Boolean>(cursor->move(child)));
+}
+
+NAN_METHOD(XmlCursor::LastChild) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  xmlNode *child =
+      has_children(cursor->xml_obj) ? cursor->xml_obj->last : NULL;
+  return info.GetReturnValue().Set(Nan::New<Boolean>(cursor->move(child)));
+}
+
+NAN_METHOD(XmlCursor::NextSibling) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  return info.GetReturnValue().Set(
+      Nan::New<Boolean>(cursor->move(cursor->xml_obj->next)));
+}
+
+NAN_METHOD(XmlCursor::PrevSibling) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  return info.GetReturnValue().Set(
+      Nan::New<Boolean>(cursor->move(cursor->xml_obj->prev)));
+}
+
+NAN_METHOD(XmlCursor::FirstElementChild) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  xmlNode *child = has_children(cursor->xml_obj)
+                       ? next_element(cursor->xml_obj->children)
+                       : NULL;
+  return info.GetReturnValue().Set(Nan::New<Boolean>(cursor->move(child)));
+}
+
+NAN_METHOD(XmlCursor::NextElementSibling) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  return info.GetReturnValue().Set(Nan::New<Boolean>(
+      cursor->move(next_element(cursor->xml_obj->next))));
+}
+
+NAN_METHOD(XmlCursor::Name) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  xmlNode *node = cursor->xml_obj;
+  switch (node->type) {
+  case XML_ELEMENT_NODE:
+  case XML_PI_NODE:
+  case XML_ENTITY_REF_NODE:
+    if (node->name != NULL) {
+      return info.GetReturnValue().Set(
+          Nan::New<String>((const char *)node->name).ToLocalChecked());
+    }
+    break;
+  default:
+    break;
+  }
+  return info.GetReturnValue().Set(Nan::Null());
+}
+
+NAN_METHOD(XmlCursor::Type) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  return info.GetReturnValue().Set(XmlNode::type_name(cursor->xml_obj->type));
+}
+
+NAN_METHOD(XmlCursor::Text) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  xmlChar *content = xmlNodeGetContent(cursor->xml_obj);
+  if (content == NULL) {
+    return info.GetReturnValue().Set(Nan::Null());
+  }
+  Local<String> text = Nan::New<String>((const char *)content).ToLocalChecked();
+  xmlFree(content);
+  return info.GetReturnValue().Set(text);
+}
+
+// name
+NAN_METHOD(XmlCursor::Attr) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsString,
+                               "Bad argument: name must be a string");
+
+  if (cursor->xml_obj->type != XML_ELEMENT_NODE) {
+    return info.GetReturnValue().Set(Nan::Null());
+  }
+  Nan::Utf8String name(info[0]);
+  return info.GetReturnValue().Set(XmlElement::attribute_value(
+      cursor->xml_obj, (const xmlChar *)*name));
+}
+
+NAN_METHOD(XmlCursor::Node) {
+  Nan::HandleScope scope;
+  XmlCursor *cursor = Unwrap(info);
+  if (cursor == NULL) {
+    return;
+  }
+
+  xmlNode *node = cursor->xml_obj;
+  if ((node->type == XML_DOCUMENT_NODE) ||
+      (node->type == XML_HTML_DOCUMENT_NODE)) {
+    return info.GetReturnValue().Set(
+        XmlDocument::New(reinterpret_cast<xmlDoc *>(node)));
+  }
+  return info.GetReturnValue().Set(XmlNode::New(node));
+}
+
+void XmlCursor::Initialize(Local<Object> target) {
+  Nan::HandleScope scope;
+
+  Local<FunctionTemplate> tmpl = Nan::New<FunctionTemplate>(New);
+  tmpl->SetClassName(Nan::New<String>("Cursor").ToLocalChecked());
+
+  constructor_template.Reset(tmpl);
+  tmpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::SetPrototypeMethod(tmpl, "parent", XmlCursor::Parent);
+  Nan::SetPrototypeMethod(tmpl, "firstChild", XmlCursor::FirstChild);
+  Nan::SetPrototypeMethod(tmpl, "lastChild", XmlCursor::LastChild);
+  Nan::SetPrototypeMethod(tmpl, "nextSibling", XmlCursor::NextSibling);
+  Nan::SetPrototypeMethod(tmpl, "prevSibling", XmlCursor::PrevSibling);
+  Nan::SetPrototypeMethod(tmpl, "firstElementChild",
+                          XmlCursor::FirstElementChild);
+  Nan::SetPrototypeMethod(tmpl, "nextElementSibling",
+                          XmlCursor::NextElementSibling);
+  Nan::SetPrototypeMethod(tmpl, "name", XmlCursor::Name);
+  Nan::SetPrototypeMethod(tmpl, "type", XmlCursor::Type);
+  Nan::SetPrototypeMethod(tmpl, "text", XmlCursor::Text);
+  Nan::SetPrototypeMethod(tmpl, "attr", XmlCursor::Attr);
+  Nan::SetPrototypeMethod(tmpl, "node", XmlCursor::Node);
+
+  Nan::Set(target, Nan::New<String>("Cursor").ToLocalChecked(),
+           Nan::GetFunction(tmpl).ToLocalChecked());
+}
+
+} // namespace libxmljs
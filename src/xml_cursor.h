@@ -0,0 +1,60 @@
+// Copyright 2009, Squish Tech, LLC.
+#ifndef SRC_XML_CURSOR_H_
+#define SRC_XML_CURSOR_H_
+
+#include <libxml/tree.h>
+
+#include "libxmljs.h"
+#include "xml_document.h"
+
+namespace libxmljs {
+
+// a position in the tree that is moved around without creating node
+// wrappers, only node() wraps the current node
+class XmlCursor : public Nan::ObjectWrap {
+public:
+  static Nan::Persistent<v8::FunctionTemplate> constructor_template;
+
+  virtual ~XmlCursor();
+
+  static void Initialize(v8::Local<v8::Object> target);
+
+  // create a cursor positioned at `node`. `context` is kept alive
+  // while the cursor is.
+  static v8::Local<v8::Object> New(xmlNode *node, XmlDocument *document,
+                                   v8::Local<v8::Object> context);
+
+  // move to `node` unless it is NULL, returning whether it moved
+  bool move(xmlNode *node);
+
+protected:
+  XmlCursor(xmlNode *node, XmlDocument *document);
+
+  static NAN_METHOD(New);
+  static NAN_METHOD(Parent);
+  static NAN_METHOD(FirstChild);
+  static NAN_METHOD(LastChild);
+  static NAN_METHOD(NextSibling);
+  static NAN_METHOD(PrevSibling);
+  static NAN_METHOD(FirstElementChild);
+  static NAN_METHOD(NextElementSibling);
+  static NAN_METHOD(Name);
+  static NAN_METHOD(Type);
+  static NAN_METHOD(Text);
+  static NAN_METHOD(Attr);
+  static NAN_METHOD(Node);
+
+  // the cursor of the call, NULL (with an exception pending) once the
+  // document has been modified
+  static XmlCursor *Unwrap(const Nan::FunctionCallbackInfo<v8::Value> &info);
+
+  xmlNode *xml_obj;
+  XmlDocument *document;
+
+  // XmlDocument::generation when the cursor was created
+  unsigned int generation;
+};
+
+} // namespace libxmljs
+
+#endif // SRC_XML_CURSOR_H_
@@ -2,12 +2,17 @@
 
 #include <node.h>
 #include <node_buffer.h>
+#include <uv.h>
 
 #include <cstring>
+#include <set>
+#include <string>
+#include <vector>
 
 //#include <libxml/tree.h>
 #include <libxml/HTMLparser.h>
 #include <libxml/HTMLtree.h>
+#include <libxml/parserInternals.h>
 #include <libxml/relaxng.h>
 #include <libxml/schematron.h>
 #include <libxml/xinclude.h>
@@ -15,9 +20,16 @@
 #include <libxml/xmlschemas.h>
 
 #include "xml_document.h"
+#include "xml_css_selector.h"
+#include "xml_cursor.h"
 #include "xml_element.h"
+#include "xml_js_object.h"
 #include "xml_namespace.h"
 #include "xml_node.h"
+#include "xml_node_index.h"
+#include "xml_relaxng_schema.h"
+#include "xml_schema.h"
+#include "xml_schematron_schema.h"
 #include "xml_syntax_error.h"
 
 using namespace v8;
@@ -30,6 +42,7 @@ NAN_METHOD(XmlDocument::Encoding) {
   Nan::HandleScope scope;
   XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
   assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
 
   // if no args, get the encoding
   if (info.Length() == 0 || info[0]->IsUndefined()) {
@@ -44,6 +57,7 @@ NAN_METHOD(XmlDocument::Encoding) {
   }
 
   // set the encoding otherwise
+  DOCUMENT_MUTATION_CHECK(document->xml_obj)
   Nan::Utf8String encoding(info[0]);
   document->setEncoding(*encoding);
   return info.GetReturnValue().Set(info.This());
@@ -61,6 +75,7 @@ NAN_METHOD(XmlDocument::Version) {
   Nan::HandleScope scope;
   XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
   assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
 
   if (document->xml_obj->version)
     return info.GetReturnValue().Set(
@@ -75,6 +90,7 @@ NAN_METHOD(XmlDocument::Root) {
   Nan::HandleScope scope;
   XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
   assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
 
   xmlNode *root = xmlDocGetRootElement(document->xml_obj);
 
@@ -85,6 +101,8 @@ NAN_METHOD(XmlDocument::Root) {
     return info.GetReturnValue().Set(XmlElement::New(root));
   }
 
+  DOCUMENT_MUTATION_CHECK(document->xml_obj)
+
   if (root != NULL) {
     return Nan::ThrowError("Holder document already has a root node");
   }
@@ -94,8 +112,18 @@ NAN_METHOD(XmlDocument::Root) {
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(
       Nan::To<Object>(info[0]).ToLocalChecked());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
+  DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
+  if (element->xml_obj->doc != document->xml_obj) {
+    // the element leaves the tree of its document
+    TreeChanged(element->xml_obj->doc);
+    NodeLeaving(element->xml_obj);
+  }
+  XmlNode::unlink_wrapped(element->xml_obj);
   xmlDocSetRootElement(document->xml_obj, element->xml_obj);
-  element->ref_wrapped_ancestor();
+  TreeChanged(document->xml_obj);
+  NodeLinked(element->xml_obj);
+  XmlNode::link_wrapped(element->xml_obj);
   return info.GetReturnValue().Set(info[0]);
 }
 
@@ -103,6 +131,7 @@ NAN_METHOD(XmlDocument::GetDtd) {
   Nan::HandleScope scope;
   XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
   assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
 
   xmlDtdPtr dtd = xmlGetIntSubset(document->xml_obj);
 
@@ -145,6 +174,8 @@ NAN_METHOD(XmlDocument::SetDtd) {
 
   XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
   assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
+  DOCUMENT_MUTATION_CHECK(document->xml_obj)
 
   Nan::Utf8String name(info[0]);
 
@@ -173,6 +204,7 @@ NAN_METHOD(XmlDocument::SetDtd) {
 
   xmlCreateIntSubset(document->xml_obj, (const xmlChar *)*name,
                      (const xmlChar *)extId, (const xmlChar *)sysId);
+  TreeChanged(document->xml_obj);
 
   return info.GetReturnValue().Set(info.This());
 }
@@ -182,6 +214,7 @@ NAN_METHOD(XmlDocument::ToString) {
 
   XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
   assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
 
   int options = 0;
   const char *encoding = "UTF-8";
@@ -582,53 +615,361 @@ NAN_METHOD(XmlDocument::FromXml) {
   return info.GetReturnValue().Set(doc_handle);
 }
 
+// Parses an xml or html document on the libuv threadpool and wraps
+// it on the main thread once the parse has completed.
+// Errors are collected per job and only turned into v8 objects
+// when back on the main thread.
+class ParseWorker : public Nan::AsyncWorker {
+public:
+  ParseWorker(Nan::Callback *callback, Local<Value> input,
+              Local<Object> options, bool html)
+      : Nan::AsyncWorker(callback, html ? "libxmljs:parseHtml"
+                                        : "libxmljs:parseXml"),
+        html(html), doc(NULL), failed(false),
+        message(html ? "Could not parse HTML string"
+                     : "Could not parse XML string") {
+    memset(&error, 0, sizeof(error));
+
+    Local<Value> baseUrlOpt =
+        Nan::Get(options, Nan::New<String>("baseUrl").ToLocalChecked())
+            .ToLocalChecked();
+    Local<Value> encodingOpt =
+        Nan::Get(options, Nan::New<String>("encoding").ToLocalChecked())
+            .ToLocalChecked();
+
+    has_base_url = baseUrlOpt->IsString();
+    if (has_base_url) {
+      base_url = *Nan::Utf8String(baseUrlOpt);
+    }
+
+    has_encoding = encodingOpt->IsString();
+    if (has_encoding) {
+      encoding = *Nan::Utf8String(encodingOpt);
+    }
+
+    opts = (int)getParserOptions(options);
+    if (html) {
+      Local<Value> excludeImpliedElementsOpt =
+          Nan::Get(options,
+                   Nan::New<String>("excludeImpliedElements").ToLocalChecked())
+              .ToLocalChecked();
+      if (Nan::To<bool>(excludeImpliedElementsOpt).ToChecked())
+        opts |= HTML_PARSE_NOIMPLIED | HTML_PARSE_NODEFDTD;
+    }
+
+    if (!node::Buffer::HasInstance(input)) {
+      // strings are copied, v8 may move or collect them while we parse
+      Nan::Utf8String str(Nan::To<String>(input).ToLocalChecked());
+      source.assign(*str, str.length());
+      data = source.data();
+      length = source.length();
+      if (!html) {
+        has_encoding = true;
+        encoding = "UTF-8";
+      }
+    } else {
+      // buffers are pinned until the job completes
+      Local<Object> buf = Nan::To<Object>(input).ToLocalChecked();
+      SaveToPersistent("input", buf);
+      data = node::Buffer::Data(buf);
+      length = node::Buffer::Length(buf);
+    }
+  }
+
+  ~ParseWorker() {
+    xmlResetError(&error);
+    for (size_t i = 0; i < errors.size(); ++i) {
+      xmlResetError(&errors[i]);
+    }
+  }
+
+  void Execute() {
+    xmlResetLastError();
+
+    const char *url = has_base_url ? base_url.c_str() : NULL;
+    const char *enc = has_encoding ? encoding.c_str() : NULL;
+
+    if (html) {
+      parse_html(url, enc);
+    } else {
+      parse_xml(url, enc);
+    }
+
+    if (!failed && !html && (opts & XML_PARSE_XINCLUDE)) {
+      // xinclude has no parser context of its own, its errors go to
+      // this thread's handler
+      xmlSetStructuredErrorFunc(reinterpret_cast<void *>(&errors),
+                                XmlSyntaxError::CopyToVector);
+      if (xmlXIncludeProcessFlags(doc, opts) < 0) {
+        fail(xmlGetLastError(), "Could not perform XInclude substitution");
+      }
+      xmlSetStructuredErrorFunc(NULL, NULL);
+    }
+
+    if (!failed && !html && (xmlDocGetRootElement(doc) == NULL)) {
+      message = "parsed document has no root element";
+      failed = true;
+    }
+
+    if (failed && (doc != NULL)) {
+      xmlFreeDoc(doc);
+      doc = NULL;
+    }
+  }
+
+  void HandleOKCallback() {
+    Nan::HandleScope scope;
+
+    Local<Array> syntax_errors = XmlSyntaxError::BuildSyntaxErrors(&errors);
+
+    if (failed) {
+      Local<Value> argv[1] = {error.message != NULL
+                                  ? XmlSyntaxError::BuildSyntaxError(&error)
+                                  : Nan::Error(message)};
+      callback->Call(1, argv, async_resource);
+      return;
+    }
+
+    Local<Object> doc_handle = XmlDocument::New(doc);
+    Nan::Set(doc_handle, Nan::New<String>("errors").ToLocalChecked(),
+             syntax_errors);
+
+    Local<Value> argv[2] = {Nan::Null(), doc_handle};
+    callback->Call(2, argv, async_resource);
+  }
+
+private:
+  // same steps as xmlReadMemory, but with a parser context of our own
+  // so that errors are reported to this job only
+  void parse_xml(const char *url, const char *enc) {
+    xmlParserCtxt *ctxt = xmlCreateMemoryParserCtxt(data, (int)length);
+    if (ctxt == NULL) {
+      fail(NULL, NULL);
+      return;
+    }
+
+    xmlCtxtUseOptions(ctxt, opts);
+    collect_errors(ctxt);
+
+    if (enc != NULL) {
+      ctxt->encoding = xmlStrdup((const xmlChar *)enc);
+      xmlCharEncodingHandler *handler = xmlFindCharEncodingHandler(enc);
+      if (handler != NULL) {
+        xmlSwitchToEncoding(ctxt, handler);
+      }
+    }
+    if ((url != NULL) && (ctxt->input != NULL) &&
+        (ctxt->input->filename == NULL)) {
+      ctxt->input->filename = (char *)xmlStrdup((const xmlChar *)url);
+    }
+
+    xmlParseDocument(ctxt);
+
+    if (ctxt->wellFormed || ctxt->recovery) {
+      doc = ctxt->myDoc;
+    } else if (ctxt->myDoc != NULL) {
+      xmlFreeDoc(ctxt->myDoc);
+    }
+    ctxt->myDoc = NULL;
+
+    if (doc == NULL) {
+      fail(&ctxt->lastError, NULL);
+    }
+    xmlFreeParserCtxt(ctxt);
+  }
+
+  // same steps as htmlReadMemory, see parse_xml
+  void parse_html(const char *url, const char *enc) {
+    htmlParserCtxt *ctxt = htmlCreateMemoryParserCtxt(data, (int)length);
+    if (ctxt == NULL) {
+      fail(NULL, NULL);
+      return;
+    }
+
+    htmlCtxtUseOptions(ctxt, opts);
+    collect_errors(ctxt);
+
+    if (enc != NULL) {
+      xmlCharEncodingHandler *handler = xmlFindCharEncodingHandler(enc);
+      if (handler != NULL) {
+        xmlSwitchToEncoding(ctxt, handler);
+        if (ctxt->input->encoding != NULL) {
+          xmlFree((xmlChar *)ctxt->input->encoding);
+        }
+        ctxt->input->encoding = xmlStrdup((const xmlChar *)enc);
+      }
+    }
+    if ((url != NULL) && (ctxt->input != NULL) &&
+        (ctxt->input->filename == NULL)) {
+      ctxt->input->filename = (char *)xmlStrdup((const xmlChar *)url);
+    }
+
+    htmlParseDocument(ctxt);
+
+    doc = ctxt->myDoc;
+    ctxt->myDoc = NULL;
+
+    if (doc == NULL) {
+      fail(&ctxt->lastError, NULL);
+    }
+    htmlFreeParserCtxt(ctxt);
+  }
+
+  // structured errors are handed the parser context, the job's errors
+  // hang off of its _private
+  static void CollectError(void *ctx, xmlError *error) {
+    xmlParserCtxt *ctxt = reinterpret_cast<xmlParserCtxt *>(ctx);
+    XmlSyntaxError::CopyToVector(ctxt->_private, error);
+  }
+
+  // after the options are applied, sax1 resets the handler's version
+  void collect_errors(xmlParserCtxt *ctxt) {
+    ctxt->_private = reinterpret_cast<void *>(&errors);
+    ctxt->sax->serror = CollectError;
+    ctxt->sax->initialized = XML_SAX2_MAGIC;
+  }
+
+  // keep the given error, if any, to report as the failure
+  void fail(xmlError *last, const char *fallback) {
+    if ((last != NULL) && (last->code != XML_ERR_OK)) {
+      xmlCopyError(last, &error);
+    } else if (fallback != NULL) {
+      message = fallback;
+    }
+    failed = true;
+  }
+
+  bool html;
+
+  std::string source;
+  const char *data;
+  size_t length;
+
+  bool has_base_url;
+  std::string base_url;
+  bool has_encoding;
+  std::string encoding;
+  int opts;
+
+  xmlDoc *doc;
+  std::vector<xmlError> errors;
+  bool failed;
+  xmlError error;
+  const char *message;
+};
+
+NAN_METHOD(XmlDocument::FromHtmlAsync) {
+  Nan::HandleScope scope;
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[2], IsFunction,
+                               "Bad argument: callback must be a function");
+
+  Local<Object> options = Nan::To<Object>(info[1]).ToLocalChecked();
+  Nan::Callback *callback = new Nan::Callback(info[2].As<Function>());
+
+  Nan::AsyncQueueWorker(new ParseWorker(callback, info[0], options, true));
+}
+
+NAN_METHOD(XmlDocument::FromXmlAsync) {
+  Nan::HandleScope scope;
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[2], IsFunction,
+                               "Bad argument: callback must be a function");
+
+  Local<Object> options = Nan::To<Object>(info[1]).ToLocalChecked();
+  Nan::Callback *callback = new Nan::Callback(info[2].As<Function>());
+
+  Nan::AsyncQueueWorker(new ParseWorker(callback, info[0], options, false));
+}
+
 NAN_METHOD(XmlDocument::Validate) {
   if (info.Length() == 0 || info[0]->IsNullOrUndefined()) {
     Nan::ThrowError("Must pass xsd");
     return;
   }
-  if (!XmlDocument::constructor_template.Get(Isolate::GetCurrent())
+
+  // a compiled schema only needs a (cheap) validation context
+  bool compiled = XmlSchema::constructor_template.Get(Isolate::GetCurrent())
+                      ->HasInstance(info[0]);
+  if (!compiled &&
+      !XmlDocument::constructor_template.Get(Isolate::GetCurrent())
            ->HasInstance(info[0])) {
-    Nan::ThrowError("Must pass XmlDocument");
+    Nan::ThrowError("Must pass XmlDocument or Schema");
     return;
   }
 
   Nan::HandleScope scope;
 
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  DOCUMENT_DISPOSED_CHECK(document)
+  if (!compiled) {
+    DOCUMENT_DISPOSED_CHECK(Nan::ObjectWrap::Unwrap<XmlDocument>(
+        Nan::To<Object>(info[0]).ToLocalChecked()))
+  }
+
   Local<Array> errors = Nan::New<Array>();
   xmlResetLastError();
   xmlSetStructuredErrorFunc(reinterpret_cast<void *>(&errors),
                             XmlSyntaxError::PushToArray);
 
-  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
-  XmlDocument *documentSchema = Nan::ObjectWrap::Unwrap<XmlDocument>(
-      Nan::To<Object>(info[0]).ToLocalChecked());
+  xmlDoc *schema_doc = NULL;
+  xmlSchemaParserCtxtPtr parser_ctxt = NULL;
+  xmlSchemaPtr schema = NULL;
+  const char *failure = NULL;
+  if (compiled) {
+    schema = Nan::ObjectWrap::Unwrap<XmlSchema>(
+                 Nan::To<Object>(info[0]).ToLocalChecked())
+                 ->xml_obj;
+  } else {
+    XmlDocument *documentSchema = Nan::ObjectWrap::Unwrap<XmlDocument>(
+        Nan::To<Object>(info[0]).ToLocalChecked());
+
+    // compiling rewrites the document it reads, compile from a copy
+    schema_doc = xmlCopyDoc(documentSchema->xml_obj, 1);
+    if (schema_doc == NULL) {
+      failure = "Could not copy the schema document";
+    } else if ((parser_ctxt = xmlSchemaNewDocParserCtxt(schema_doc)) ==
+               NULL) {
+      failure = "Could not create context for schema parser";
+    } else if ((schema = xmlSchemaParse(parser_ctxt)) == NULL) {
+      failure = "Invalid XSD schema";
+    }
+  }
 
-  xmlSchemaParserCtxtPtr parser_ctxt =
-      xmlSchemaNewDocParserCtxt(documentSchema->xml_obj);
-  if (parser_ctxt == NULL) {
-    return Nan::ThrowError("Could not create context for schema parser");
+  xmlSchemaValidCtxtPtr valid_ctxt = NULL;
+  bool valid = false;
+  if (failure == NULL) {
+    valid_ctxt = xmlSchemaNewValidCtxt(schema);
+    if (valid_ctxt == NULL) {
+      failure = "Unable to create a validation context for the schema";
+    } else {
+      valid = xmlSchemaValidateDoc(valid_ctxt, document->xml_obj) == 0;
+      xmlSchemaFreeValidCtxt(valid_ctxt);
+    }
   }
-  xmlSchemaPtr schema = xmlSchemaParse(parser_ctxt);
-  if (schema == NULL) {
-    return Nan::ThrowError("Invalid XSD schema");
+
+  xmlSetStructuredErrorFunc(NULL, NULL);
+
+  if (!compiled) {
+    if (schema != NULL) {
+      xmlSchemaFree(schema);
+    }
+    if (parser_ctxt != NULL) {
+      xmlSchemaFreeParserCtxt(parser_ctxt);
+    }
+    if (schema_doc != NULL) {
+      xmlFreeDoc(schema_doc);
+    }
   }
-  xmlSchemaValidCtxtPtr valid_ctxt = xmlSchemaNewValidCtxt(schema);
-  if (valid_ctxt == NULL) {
-    return Nan::ThrowError(
-        "Unable to create a validation context for the schema");
+
+  if (failure != NULL) {
+    return Nan::ThrowError(failure);
   }
-  bool valid = xmlSchemaValidateDoc(valid_ctxt, document->xml_obj) == 0;
 
-  xmlSetStructuredErrorFunc(NULL, NULL);
   Nan::Set(info.This(), Nan::New<String>("validationErrors").ToLocalChecked(),
            errors)
       .Check();
 
-  xmlSchemaFreeValidCtxt(valid_ctxt);
-  xmlSchemaFree(schema);
-  xmlSchemaFreeParserCtxt(parser_ctxt);
-
   return info.GetReturnValue().Set(Nan::New<Boolean>(valid));
 }
 
@@ -638,33 +979,51 @@ NAN_METHOD(XmlDocument::RngValidate) {
     return;
   }
 
-  if (!XmlDocument::constructor_template.Get(Isolate::GetCurrent())
+  // a compiled grammar only needs a (cheap) validation context
+  bool compiled =
+      XmlRelaxNGSchema::constructor_template.Get(Isolate::GetCurrent())
+          ->HasInstance(info[0]);
+  if (!compiled &&
+      !XmlDocument::constructor_template.Get(Isolate::GetCurrent())
            ->HasInstance(info[0])) {
-    Nan::ThrowError("Must pass XmlDocument");
+    Nan::ThrowError("Must pass XmlDocument or RelaxNGSchema");
     return;
   }
 
   Nan::HandleScope scope;
 
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  DOCUMENT_DISPOSED_CHECK(document)
+  if (!compiled) {
+    DOCUMENT_DISPOSED_CHECK(Nan::ObjectWrap::Unwrap<XmlDocument>(
+        Nan::To<Object>(info[0]).ToLocalChecked()))
+  }
+
   Local<Array> errors = Nan::New<Array>();
   xmlResetLastError();
   xmlSetStructuredErrorFunc(reinterpret_cast<void *>(&errors),
                             XmlSyntaxError::PushToArray);
 
-  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
-  XmlDocument *documentSchema = Nan::ObjectWrap::Unwrap<XmlDocument>(
-      Nan::To<Object>(info[0]).ToLocalChecked());
+  xmlRelaxNGParserCtxtPtr parser_ctxt = NULL;
+  xmlRelaxNGPtr schema = NULL;
+  if (compiled) {
+    schema = Nan::ObjectWrap::Unwrap<XmlRelaxNGSchema>(
+                 Nan::To<Object>(info[0]).ToLocalChecked())
+                 ->xml_obj;
+  } else {
+    XmlDocument *documentSchema = Nan::ObjectWrap::Unwrap<XmlDocument>(
+        Nan::To<Object>(info[0]).ToLocalChecked());
 
-  xmlRelaxNGParserCtxtPtr parser_ctxt =
-      xmlRelaxNGNewDocParserCtxt(documentSchema->xml_obj);
-  if (parser_ctxt == NULL) {
-    return Nan::ThrowError(
-        "Could not create context for RELAX NG schema parser");
-  }
+    parser_ctxt = xmlRelaxNGNewDocParserCtxt(documentSchema->xml_obj);
+    if (parser_ctxt == NULL) {
+      return Nan::ThrowError(
+          "Could not create context for RELAX NG schema parser");
+    }
 
-  xmlRelaxNGPtr schema = xmlRelaxNGParse(parser_ctxt);
-  if (schema == NULL) {
-    return Nan::ThrowError("Invalid RELAX NG schema");
+    schema = xmlRelaxNGParse(parser_ctxt);
+    if (schema == NULL) {
+      return Nan::ThrowError("Invalid RELAX NG schema");
+    }
   }
 
   xmlRelaxNGValidCtxtPtr valid_ctxt = xmlRelaxNGNewValidCtxt(schema);
@@ -680,8 +1039,10 @@ NAN_METHOD(XmlDocument::RngValidate) {
       .Check();
 
   xmlRelaxNGFreeValidCtxt(valid_ctxt);
-  xmlRelaxNGFree(schema);
-  xmlRelaxNGFreeParserCtxt(parser_ctxt);
+  if (!compiled) {
+    xmlRelaxNGFree(schema);
+    xmlRelaxNGFreeParserCtxt(parser_ctxt);
+  }
 
   return info.GetReturnValue().Set(Nan::New<Boolean>(valid));
 }
@@ -692,38 +1053,58 @@ NAN_METHOD(XmlDocument::SchematronValidate) {
     return;
   }
 
-  if (!XmlDocument::constructor_template.Get(Isolate::GetCurrent())
+  // a compiled schema brings its own validation context along
+  bool compiled =
+      XmlSchematronSchema::constructor_template.Get(Isolate::GetCurrent())
+          ->HasInstance(info[0]);
+  if (!compiled &&
+      !XmlDocument::constructor_template.Get(Isolate::GetCurrent())
            ->HasInstance(info[0])) {
-    Nan::ThrowError("Must pass XmlDocument");
+    Nan::ThrowError("Must pass XmlDocument or SchematronSchema");
     return;
   }
 
   Nan::HandleScope scope;
 
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  DOCUMENT_DISPOSED_CHECK(document)
+  if (!compiled) {
+    DOCUMENT_DISPOSED_CHECK(Nan::ObjectWrap::Unwrap<XmlDocument>(
+        Nan::To<Object>(info[0]).ToLocalChecked()))
+  }
+
   Local<Array> errors = Nan::New<Array>();
   xmlResetLastError();
 
-  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
-  XmlDocument *documentSchema = Nan::ObjectWrap::Unwrap<XmlDocument>(
-      Nan::To<Object>(info[0]).ToLocalChecked());
+  xmlSchematronParserCtxtPtr parser_ctxt = NULL;
+  xmlSchematronPtr schema = NULL;
+  xmlSchematronValidCtxtPtr valid_ctxt = NULL;
+  if (compiled) {
+    valid_ctxt = Nan::ObjectWrap::Unwrap<XmlSchematronSchema>(
+                     Nan::To<Object>(info[0]).ToLocalChecked())
+                     ->valid_ctxt;
+  } else {
+    XmlDocument *documentSchema = Nan::ObjectWrap::Unwrap<XmlDocument>(
+        Nan::To<Object>(info[0]).ToLocalChecked());
 
-  xmlSchematronParserCtxtPtr parser_ctxt =
-      xmlSchematronNewDocParserCtxt(documentSchema->xml_obj);
-  if (parser_ctxt == NULL) {
-    return Nan::ThrowError(
-        "Could not create context for Schematron schema parser");
-  }
+    parser_ctxt = xmlSchematronNewDocParserCtxt(documentSchema->xml_obj);
+    if (parser_ctxt == NULL) {
+      return Nan::ThrowError(
+          "Could not create context for Schematron schema parser");
+    }
 
-  xmlSchematronPtr schema = xmlSchematronParse(parser_ctxt);
-  if (schema == NULL) {
-    return Nan::ThrowError("Invalid Schematron schema");
-  }
+    schema = xmlSchematronParse(parser_ctxt);
+    if (schema == NULL) {
+      return Nan::ThrowError("Invalid Schematron schema");
+    }
 
-  xmlSchematronValidCtxtPtr valid_ctxt = xmlSchematronNewValidCtxt(schema, XML_SCHEMATRON_OUT_ERROR);
-  if (valid_ctxt == NULL) {
-    return Nan::ThrowError(
-        "Unable to create a validation context for the Schematron schema");
+    valid_ctxt = xmlSchematronNewValidCtxt(schema, XML_SCHEMATRON_OUT_ERROR);
+    if (valid_ctxt == NULL) {
+      return Nan::ThrowError(
+          "Unable to create a validation context for the Schematron schema");
+    }
   }
+
   xmlSchematronSetValidStructuredErrors(valid_ctxt,
                                         XmlSyntaxError::PushToArray,
                                         reinterpret_cast<void *>(&errors));
@@ -735,13 +1116,586 @@ NAN_METHOD(XmlDocument::SchematronValidate) {
            errors)
       .Check();
 
-  xmlSchematronFreeValidCtxt(valid_ctxt);
-  xmlSchematronFree(schema);
-  xmlSchematronFreeParserCtxt(parser_ctxt);
+  if (!compiled) {
+    xmlSchematronFreeValidCtxt(valid_ctxt);
+    xmlSchematronFree(schema);
+    xmlSchematronFreeParserCtxt(parser_ctxt);
+  }
 
   return info.GetReturnValue().Set(Nan::New<Boolean>(valid));
 }
 
+// Validates a document against an xsd, RELAX NG or Schematron schema
+// on the libuv threadpool. The document is flagged busy until the job
+// completes so that its tree cannot change underneath the validator.
+class ValidateWorker : public Nan::AsyncWorker {
+public:
+  enum Kind { XSD, RELAXNG, SCHEMATRON };
+
+  ValidateWorker(Nan::Callback *callback, Kind kind, Local<Object> doc_handle,
+                 Local<Object> schema_handle, void *compiled_schema)
+      : Nan::AsyncWorker(callback, "libxmljs:validate"), kind(kind),
+        document(Nan::ObjectWrap::Unwrap<XmlDocument>(doc_handle)),
+        schema(compiled_schema), schema_doc(NULL), owns_schema(false),
+        valid(false), message(NULL) {
+    // keep the document and the schema alive until the job completes
+    SaveToPersistent("document", doc_handle);
+    SaveToPersistent("schema", schema_handle);
+
+    document->background_jobs++;
+    if (schema == NULL) {
+      compile(Nan::ObjectWrap::Unwrap<XmlDocument>(schema_handle)->xml_obj);
+    }
+  }
+
+  ~ValidateWorker() {
+    if (owns_schema) {
+      switch (kind) {
+      case XSD:
+        xmlSchemaFree(static_cast<xmlSchemaPtr>(schema));
+        break;
+      case RELAXNG:
+        xmlRelaxNGFree(static_cast<xmlRelaxNGPtr>(schema));
+        break;
+      case SCHEMATRON:
+        xmlSchematronFree(static_cast<xmlSchematronPtr>(schema));
+        break;
+      }
+    }
+    if (schema_doc != NULL) {
+      xmlFreeDoc(schema_doc);
+    }
+    for (size_t i = 0; i < errors.size(); ++i) {
+      xmlResetError(&errors[i]);
+    }
+  }
+
+  void Execute() {
+    if (message != NULL) {
+      return;
+    }
+
+    switch (kind) {
+    case XSD:
+      validate_xsd();
+      break;
+    case RELAXNG:
+      validate_relaxng();
+      break;
+    case SCHEMATRON:
+      validate_schematron();
+      break;
+    }
+  }
+
+  void HandleOKCallback() {
+    Nan::HandleScope scope;
+
+    document->background_jobs--;
+
+    Local<Array> validation_errors =
+        XmlSyntaxError::BuildSyntaxErrors(&errors);
+
+    if (message != NULL) {
+      Local<Value> argv[1] = {Nan::Error(message)};
+      callback->Call(1, argv, async_resource);
+      return;
+    }
+
+    Local<Object> result = Nan::New<Object>();
+    Nan::Set(result, Nan::New<String>("valid").ToLocalChecked(),
+             Nan::New<Boolean>(valid));
+    Nan::Set(result, Nan::New<String>("errors").ToLocalChecked(),
+             validation_errors);
+
+    Local<Value> argv[2] = {Nan::Null(), result};
+    callback->Call(2, argv, async_resource);
+  }
+
+private:
+  // schemas passed as a document are compiled here, on the main thread:
+  // compiling frees nodes of the document it reads, so xsd and schematron
+  // read a copy owned by the job (relax ng copies the document itself)
+  void compile(xmlDoc *source) {
+    void *errs = reinterpret_cast<void *>(&errors);
+
+    if (kind != RELAXNG) {
+      schema_doc = xmlCopyDoc(source, 1);
+      if (schema_doc == NULL) {
+        message = "Could not copy the schema document";
+        return;
+      }
+    }
+
+    switch (kind) {
+    case XSD: {
+      xmlSchemaParserCtxtPtr parser_ctxt =
+          xmlSchemaNewDocParserCtxt(schema_doc);
+      if (parser_ctxt == NULL) {
+        message = "Could not create context for schema parser";
+        return;
+      }
+      xmlSchemaSetParserStructuredErrors(parser_ctxt,
+                                         XmlSyntaxError::CopyToVector, errs);
+      schema = xmlSchemaParse(parser_ctxt);
+      xmlSchemaFreeParserCtxt(parser_ctxt);
+      if (schema == NULL) {
+        message = "Invalid XSD schema";
+      }
+      break;
+    }
+    case RELAXNG: {
+      xmlRelaxNGParserCtxtPtr parser_ctxt = xmlRelaxNGNewDocParserCtxt(source);
+      if (parser_ctxt == NULL) {
+        message = "Could not create context for RELAX NG schema parser";
+        return;
+      }
+      xmlRelaxNGSetParserStructuredErrors(parser_ctxt,
+                                          XmlSyntaxError::CopyToVector, errs);
+      schema = xmlRelaxNGParse(parser_ctxt);
+      xmlRelaxNGFreeParserCtxt(parser_ctxt);
+      if (schema == NULL) {
+        message = "Invalid RELAX NG schema";
+      }
+      break;
+    }
+    case SCHEMATRON: {
+      xmlSchematronParserCtxtPtr parser_ctxt =
+          xmlSchematronNewDocParserCtxt(schema_doc);
+      if (parser_ctxt == NULL) {
+        message = "Could not create context for Schematron schema parser";
+        return;
+      }
+      // the schematron parser has no structured error setter
+      xmlSetStructuredErrorFunc(errs, XmlSyntaxError::CopyToVector);
+      schema = xmlSchematronParse(parser_ctxt);
+      xmlSetStructuredErrorFunc(NULL, NULL);
+      xmlSchematronFreeParserCtxt(parser_ctxt);
+      if (schema == NULL) {
+        message = "Invalid Schematron schema";
+      }
+      break;
+    }
+    }
+
+    owns_schema = schema != NULL;
+  }
+
+  void validate_xsd() {
+    xmlSchemaValidCtxtPtr valid_ctxt =
+        xmlSchemaNewValidCtxt(static_cast<xmlSchemaPtr>(schema));
+    if (valid_ctxt == NULL) {
+      message = "Unable to create a validation context for the schema";
+      return;
+    }
+    xmlSchemaSetValidStructuredErrors(valid_ctxt, XmlSyntaxError::CopyToVector,
+                                      reinterpret_cast<void *>(&errors));
+    valid = xmlSchemaValidateDoc(valid_ctxt, document->xml_obj) == 0;
+    xmlSchemaFreeValidCtxt(valid_ctxt);
+  }
+
+  void validate_relaxng() {
+    xmlRelaxNGValidCtxtPtr valid_ctxt =
+        xmlRelaxNGNewValidCtxt(static_cast<xmlRelaxNGPtr>(schema));
+    if (valid_ctxt == NULL) {
+      message =
+          "Unable to create a validation context for the RELAX NG schema";
+      return;
+    }
+    xmlRelaxNGSetValidStructuredErrors(valid_ctxt,
+                                       XmlSyntaxError::CopyToVector,
+                                       reinterpret_cast<void *>(&errors));
+    valid = xmlRelaxNGValidateDoc(valid_ctxt, document->xml_obj) == 0;
+    xmlRelaxNGFreeValidCtxt(valid_ctxt);
+  }
+
+  void validate_schematron() {
+    // never share the validation context of a compiled schema, the
+    // main thread may be using it at the same time
+    xmlSchematronValidCtxtPtr valid_ctxt = xmlSchematronNewValidCtxt(
+        static_cast<xmlSchematronPtr>(schema), XML_SCHEMATRON_OUT_ERROR);
+    if (valid_ctxt == NULL) {
+      message =
+          "Unable to create a validation context for the Schematron schema";
+      return;
+    }
+    xmlSchematronSetValidStructuredErrors(valid_ctxt,
+                                          XmlSyntaxError::CopyToVector,
+                                          reinterpret_cast<void *>(&errors));
+    valid = xmlSchematronValidateDoc(valid_ctxt, document->xml_obj) == 0;
+    xmlSchematronFreeValidCtxt(valid_ctxt);
+  }
+
+  Kind kind;
+  XmlDocument *document;
+  void *schema;
+  xmlDoc *schema_doc;
+  bool owns_schema;
+
+  std::vector<xmlError> errors;
+  bool valid;
+  const char *message;
+};
+
+NAN_METHOD(XmlDocument::ValidateAsync) {
+  Nan::HandleScope scope;
+
+  if (info.Length() == 0 || info[0]->IsNullOrUndefined()) {
+    return Nan::ThrowError("Must pass xsd");
+  }
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[1], IsFunction,
+                               "Bad argument: callback must be a function");
+
+  Local<Object> schema = Nan::To<Object>(info[0]).ToLocalChecked();
+  xmlSchemaPtr compiled = NULL;
+  if (XmlSchema::constructor_template.Get(Isolate::GetCurrent())
+          ->HasInstance(schema)) {
+    compiled = Nan::ObjectWrap::Unwrap<XmlSchema>(schema)->xml_obj;
+  } else if (!XmlDocument::constructor_template.Get(Isolate::GetCurrent())
+                  ->HasInstance(schema)) {
+    return Nan::ThrowError("Must pass XmlDocument or Schema");
+  }
+
+  DOCUMENT_DISPOSED_CHECK(Nan::ObjectWrap::Unwrap<XmlDocument>(info.This()))
+  if (compiled == NULL) {
+    DOCUMENT_DISPOSED_CHECK(Nan::ObjectWrap::Unwrap<XmlDocument>(schema))
+  }
+
+  Nan::Callback *callback = new Nan::Callback(info[1].As<Function>());
+  Nan::AsyncQueueWorker(new ValidateWorker(callback, ValidateWorker::XSD,
+                                           info.This(), schema, compiled));
+}
+
+NAN_METHOD(XmlDocument::RngValidateAsync) {
+  Nan::HandleScope scope;
+
+  if (info.Length() == 0 || info[0]->IsNullOrUndefined()) {
+    return Nan::ThrowError("Must pass xsd");
+  }
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[1], IsFunction,
+                               "Bad argument: callback must be a function");
+
+  Local<Object> schema = Nan::To<Object>(info[0]).ToLocalChecked();
+  xmlRelaxNGPtr compiled = NULL;
+  if (XmlRelaxNGSchema::constructor_template.Get(Isolate::GetCurrent())
+          ->HasInstance(schema)) {
+    compiled = Nan::ObjectWrap::Unwrap<XmlRelaxNGSchema>(schema)->xml_obj;
+  } else if (!XmlDocument::constructor_template.Get(Isolate::GetCurrent())
+                  ->HasInstance(schema)) {
+    return Nan::ThrowError("Must pass XmlDocument or RelaxNGSchema");
+  }
+
+  DOCUMENT_DISPOSED_CHECK(Nan::ObjectWrap::Unwrap<XmlDocument>(info.This()))
+  if (compiled == NULL) {
+    DOCUMENT_DISPOSED_CHECK(Nan::ObjectWrap::Unwrap<XmlDocument>(schema))
+  }
+
+  Nan::Callback *callback = new Nan::Callback(info[1].As<Function>());
+  Nan::AsyncQueueWorker(new ValidateWorker(callback, ValidateWorker::RELAXNG,
+                                           info.This(), schema, compiled));
+}
+
+NAN_METHOD(XmlDocument::SchematronValidateAsync) {
+  Nan::HandleScope scope;
+
+  if (info.Length() == 0 || info[0]->IsNullOrUndefined()) {
+    return Nan::ThrowError("Must pass schema");
+  }
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[1], IsFunction,
+                               "Bad argument: callback must be a function");
+
+  Local<Object> schema = Nan::To<Object>(info[0]).ToLocalChecked();
+  xmlSchematronPtr compiled = NULL;
+  if (XmlSchematronSchema::constructor_template.Get(Isolate::GetCurrent())
+          ->HasInstance(schema)) {
+    compiled = Nan::ObjectWrap::Unwrap<XmlSchematronSchema>(schema)->xml_obj;
+  } else if (!XmlDocument::constructor_template.Get(Isolate::GetCurrent())
+                  ->HasInstance(schema)) {
+    return Nan::ThrowError("Must pass XmlDocument or SchematronSchema");
+  }
+
+  DOCUMENT_DISPOSED_CHECK(Nan::ObjectWrap::Unwrap<XmlDocument>(info.This()))
+  if (compiled == NULL) {
+    DOCUMENT_DISPOSED_CHECK(Nan::ObjectWrap::Unwrap<XmlDocument>(schema))
+  }
+
+  Nan::Callback *callback = new Nan::Callback(info[1].As<Function>());
+  Nan::AsyncQueueWorker(new ValidateWorker(
+      callback, ValidateWorker::SCHEMATRON, info.This(), schema, compiled));
+}
+
+// {prefix: href}
+NAN_METHOD(XmlDocument::RegisterXPathNamespaces) {
+  Nan::HandleScope scope;
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsObject,
+                               "Bad argument: namespaces must be an object");
+
+  if (document->xpath_ctxt == NULL) {
+    document->xpath_ctxt = xmlXPathNewContext(document->xml_obj);
+  }
+
+  Local<Object> namespaces = Nan::To<Object>(info[0]).ToLocalChecked();
+  Local<Array> properties = Nan::GetPropertyNames(namespaces).ToLocalChecked();
+  for (unsigned int i = 0; i < properties->Length(); i++) {
+    Local<String> prop_name =
+        Nan::To<String>(
+            Nan::Get(properties, Nan::New<Number>(i)).ToLocalChecked())
+            .ToLocalChecked();
+    Nan::Utf8String prefix(prop_name);
+    Local<Value> href = Nan::Get(namespaces, prop_name).ToLocalChecked();
+
+    // a null href removes a previously registered prefix
+    if (href->IsNull()) {
+      xmlXPathRegisterNs(document->xpath_ctxt, (const xmlChar *)*prefix, NULL);
+    } else {
+      Nan::Utf8String uri(href);
+      xmlXPathRegisterNs(document->xpath_ctxt, (const xmlChar *)*prefix,
+                         (const xmlChar *)*uri);
+    }
+  }
+
+  return info.GetReturnValue().Set(info.This());
+}
+
+XmlNodeIndex *XmlDocument::index() {
+  if (node_index == NULL) {
+    node_index = new XmlNodeIndex(xml_obj);
+  }
+  return node_index;
+}
+
+// {attribute: name or [names]}, the "id" attribute by default
+NAN_METHOD(XmlDocument::BuildIndex) {
+  Nan::HandleScope scope;
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
+
+  Local<Value> attributes = Nan::New<String>("id").ToLocalChecked();
+  if (info.Length() > 0 && !info[0]->IsUndefined()) {
+    LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsObject,
+                                 "Bad argument: options must be an object");
+    Local<Value> option =
+        Nan::Get(Nan::To<Object>(info[0]).ToLocalChecked(),
+                 Nan::New<String>("attribute").ToLocalChecked())
+            .ToLocalChecked();
+    if (!option->IsUndefined()) {
+      attributes = option;
+    }
+  }
+
+  if (attributes->IsString()) {
+    Nan::Utf8String name(attributes);
+    document->index()->build_attribute(*name);
+  } else if (attributes->IsArray()) {
+    Local<Array> names = Local<Array>::Cast(attributes);
+    for (unsigned int i = 0; i < names->Length(); i++) {
+      Local<Value> name = Nan::Get(names, i).ToLocalChecked();
+      if (!name->IsString()) {
+        return Nan::ThrowTypeError(
+            "Bad argument: attribute must be a string or an array of strings");
+      }
+      document->index()->build_attribute(*Nan::Utf8String(name));
+    }
+  } else {
+    return Nan::ThrowTypeError(
+        "Bad argument: attribute must be a string or an array of strings");
+  }
+
+  return info.GetReturnValue().Set(info.This());
+}
+
+// lookup(attribute, value)
+NAN_METHOD(XmlDocument::Lookup) {
+  Nan::HandleScope scope;
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsString,
+                               "Bad argument: attribute must be a string");
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[1], IsString,
+                               "Bad argument: value must be a string");
+
+  xmlNode *element = document->index()->lookup_attribute(
+      *Nan::Utf8String(info[0]), *Nan::Utf8String(info[1]));
+  if (element == NULL) {
+    return info.GetReturnValue().Set(Nan::Null());
+  }
+  return info.GetReturnValue().Set(XmlElement::New(element));
+}
+
+// whether the node is (still) part of the tree of the document
+static bool attachedTo(xmlDoc *doc, xmlNode *node) {
+  while (node->parent != NULL) {
+    node = node->parent;
+  }
+  return node == reinterpret_cast<xmlNode *>(doc);
+}
+
+NAN_METHOD(XmlDocument::GetElementById) {
+  Nan::HandleScope scope;
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsString,
+                               "Bad argument: id must be a string");
+  Nan::Utf8String id(info[0]);
+
+  // attributes declared as ID by the DTD, xml:id and the id of html
+  // documents are kept in a table by libxml already
+  xmlNode *element = NULL;
+  xmlAttr *attr = xmlGetID(document->xml_obj, (const xmlChar *)*id);
+  // streaming parsers register ids without the attribute node
+  if ((attr != NULL) && (attr->type == XML_ATTRIBUTE_NODE) &&
+      (attr->parent != NULL) && attachedTo(document->xml_obj, attr->parent)) {
+    element = attr->parent;
+  }
+
+  // otherwise plain "id" attributes
+  if (element == NULL) {
+    element = document->index()->lookup_attribute("id", *id);
+  }
+
+  if (element == NULL) {
+    return info.GetReturnValue().Set(Nan::Null());
+  }
+  return info.GetReturnValue().Set(XmlElement::New(element));
+}
+
+// name, [nsUri], any namespace unless given, null for no namespace
+void XmlDocument::elements_by_tag_name(
+    const Nan::FunctionCallbackInfo<Value> &info, xmlDoc *doc,
+    xmlNode *within) {
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsString,
+                               "Bad argument: name must be a string");
+  Nan::Utf8String name(info[0]);
+
+  bool any_ns = (info.Length() < 2) || info[1]->IsUndefined();
+  Nan::Utf8String href(info[1]);
+  if (!any_ns && !info[1]->IsNull() && !info[1]->IsString()) {
+    return Nan::ThrowTypeError(
+        "Bad argument: namespace must be a string or null");
+  }
+
+  XmlDocument *document = static_cast<XmlDocument *>(doc->_private);
+  std::vector<xmlNode *> found;
+  document->index()->find_elements(
+      (const xmlChar *)*name, within, any_ns,
+      info[1]->IsString() ? (const xmlChar *)*href : NULL,
+      document->generation, found);
+
+  Local<Array> elements = Nan::New<Array>(static_cast<int>(found.size()));
+  for (size_t i = 0; i < found.size(); i++) {
+    Nan::Set(elements, i, XmlElement::New(found[i]));
+  }
+  return info.GetReturnValue().Set(elements);
+}
+
+NAN_METHOD(XmlDocument::GetElementsByTagName) {
+  Nan::HandleScope scope;
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
+
+  elements_by_tag_name(info, document->xml_obj, NULL);
+}
+
+// selector, the root element may match as well
+NAN_METHOD(XmlDocument::QuerySelector) {
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
+
+  XmlCssSelector::query(
+      info, reinterpret_cast<xmlNode *>(document->xml_obj), false);
+}
+
+// selector
+NAN_METHOD(XmlDocument::QuerySelectorAll) {
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
+
+  XmlCssSelector::query(
+      info, reinterpret_cast<xmlNode *>(document->xml_obj), true);
+}
+
+NAN_METHOD(XmlDocument::ToFlatTree) {
+  Nan::HandleScope scope;
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
+
+  return info.GetReturnValue().Set(
+      flatTree(reinterpret_cast<xmlNode *>(document->xml_obj)));
+}
+
+NAN_METHOD(XmlDocument::Cursor) {
+  Nan::HandleScope scope;
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
+
+  return info.GetReturnValue().Set(XmlCursor::New(
+      reinterpret_cast<xmlNode *>(document->xml_obj), document, info.This()));
+}
+
+NAN_METHOD(XmlDocument::Dispose) {
+  Nan::HandleScope scope;
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(info.This());
+  assert(document);
+
+  if (document->xml_obj == NULL) {
+    return;
+  }
+  if (document->background_jobs > 0) {
+    return Nan::ThrowError(
+        "Document is in use by a background job and cannot be disposed");
+  }
+
+  document->dispose();
+  syncExternalMemory();
+}
+
+// {rootName: content}, [{attributePrefix, textKey}]
+NAN_METHOD(XmlDocument::FromObject) {
+  Nan::HandleScope scope;
+
+  XmlFromObject builder;
+  if (!builder.set_options(info[1])) {
+    return;
+  }
+
+  Local<Object> obj =
+      Nan::NewInstance(
+          Nan::GetFunction(Nan::New(constructor_template)).ToLocalChecked())
+          .ToLocalChecked();
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(obj);
+
+  if (!builder.append(reinterpret_cast<xmlNode *>(document->xml_obj),
+                      info[0])) {
+    return;
+  }
+
+  int roots = 0;
+  for (xmlNode *child = document->xml_obj->children; child != NULL;
+       child = child->next) {
+    roots += (child->type == XML_ELEMENT_NODE) ? 1 : 0;
+  }
+  if (roots != 1) {
+    return Nan::ThrowError(
+        "Bad argument: content must describe exactly one root element");
+  }
+
+  return info.GetReturnValue().Set(obj);
+}
+
 /// this is a blank object with prototype methods
 /// not exposed to the user and not called from js
 NAN_METHOD(XmlDocument::New) {
@@ -763,12 +1717,212 @@ NAN_METHOD(XmlDocument::New) {
   return info.GetReturnValue().Set(info.This());
 }
 
-XmlDocument::XmlDocument(xmlDoc *doc) : xml_obj(doc) {
+XmlDocument::XmlDocument(xmlDoc *doc)
+    : xml_obj(doc), background_jobs(0), generation(0), xpath_ctxt(NULL),
+      node_index(NULL), wrappers(NULL) {
   xml_obj->_private = this;
 }
 
+const char *XmlDocument::ModifyError(xmlDoc *doc) {
+  if (doc == NULL || doc->_private == NULL) {
+    return NULL;
+  }
+  XmlDocument *document = static_cast<XmlDocument *>(doc->_private);
+  if (document->background_jobs > 0) {
+    return "Document is in use by a background job and cannot be modified";
+  }
+  return NULL;
+}
+
+void XmlDocument::TreeChanged(xmlDoc *doc) {
+  if (doc != NULL && doc->_private != NULL) {
+    static_cast<XmlDocument *>(doc->_private)->generation++;
+  }
+}
+
+// the index of the document of the node, NULL unless one was created
+static XmlNodeIndex *indexOf(xmlNode *node) {
+  if ((node->doc == NULL) || (node->doc->_private == NULL)) {
+    return NULL;
+  }
+  return static_cast<XmlDocument *>(node->doc->_private)->index_if_any();
+}
+
+void XmlDocument::NodeLinked(xmlNode *node) {
+  XmlNodeIndex *index = indexOf(node);
+  if (index != NULL) {
+    index->linked(node);
+  }
+}
+
+void XmlDocument::AttributesChanged(xmlNode *element) {
+  XmlNodeIndex *index = indexOf(element);
+  if (index != NULL) {
+    index->attributes_changed(element);
+  }
+}
+
+void XmlDocument::NodeFreed(xmlNode *node) {
+  if (node->type != XML_ELEMENT_NODE) {
+    return;
+  }
+  XmlNodeIndex *index = indexOf(node);
+  if (index != NULL) {
+    index->freed(node);
+  }
+}
+
+void XmlDocument::NodeLeaving(xmlNode *node) {
+  XmlNodeIndex *index = indexOf(node);
+  if (index != NULL) {
+    index->leaving(node);
+  }
+}
+
+void XmlDocument::add_wrapper(XmlNode *node) {
+  node->prev_wrapper = NULL;
+  node->next_wrapper = wrappers;
+  if (wrappers != NULL) {
+    wrappers->prev_wrapper = node;
+  }
+  wrappers = node;
+}
+
+void XmlDocument::remove_wrapper(XmlNode *node) {
+  if (node->prev_wrapper != NULL) {
+    node->prev_wrapper->next_wrapper = node->next_wrapper;
+  } else {
+    wrappers = node->next_wrapper;
+  }
+  if (node->next_wrapper != NULL) {
+    node->next_wrapper->prev_wrapper = node->prev_wrapper;
+  }
+  node->prev_wrapper = NULL;
+  node->next_wrapper = NULL;
+}
+
+void XmlDocument::dispose() {
+  // iterators and cursors into the tree are stale from here on
+  generation++;
+
+  if (xpath_ctxt != NULL) {
+    xmlXPathFreeContext(xpath_ctxt);
+    xpath_ctxt = NULL;
+  }
+  delete node_index;
+  node_index = NULL;
+
+  // the trees removed from the document that the wrappers keep alive
+  // are freed as well, those use the dictionary of the document
+  xmlNode *top = reinterpret_cast<xmlNode *>(xml_obj);
+  std::set<xmlNode *> detached;
+  for (XmlNode *node = wrappers; node != NULL; node = node->next_wrapper) {
+    if (node->xml_obj == NULL) {
+      continue;
+    }
+    xmlNode *root = node->xml_obj;
+    while (root->parent != NULL) {
+      root = root->parent;
+    }
+    if ((root != top) && (root->doc == xml_obj)) {
+      detached.insert(root);
+    }
+  }
+  for (std::set<xmlNode *>::iterator it = detached.begin();
+       it != detached.end(); ++it) {
+    xmlFreeNode(*it);
+  }
+
+  // the deregister callback sets xml_obj of every wrapper to NULL
+  xml_obj->_private = NULL;
+  xmlFreeDoc(xml_obj);
+  xml_obj = NULL;
+}
+
+// documents with more nodes than this are freed on the thread pool, so
+// that finalizing them doesn't stall the main thread
+static const size_t BACKGROUND_FREE_MIN_NODES = 10000;
+
+static bool hasWrappedNamespace(xmlNs *ns) {
+  for (; ns != NULL; ns = ns->next) {
+    if (ns->_private != NULL) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// whether the tree of the document is worth freeing on the thread pool:
+// it has to be large and none of its nodes may be wrapped. Wrappers of
+// nodes moved in from another document hold on to that document, not to
+// this one, and must be updated on the main thread as the nodes go.
+static bool mayFreeInBackground(xmlDoc *doc) {
+  if (hasWrappedNamespace(doc->oldNs)) {
+    return false;
+  }
+
+  xmlNode *top = reinterpret_cast<xmlNode *>(doc);
+  xmlNode *node = doc->children;
+  size_t count = 0;
+  while (node != NULL) {
+    count++;
+    if (node->_private != NULL) {
+      return false;
+    }
+    if (node->type == XML_ELEMENT_NODE) {
+      if (hasWrappedNamespace(node->nsDef)) {
+        return false;
+      }
+      for (xmlAttr *attr = node->properties; attr != NULL; attr = attr->next) {
+        if (attr->_private != NULL) {
+          return false;
+        }
+      }
+      if (node->children != NULL) {
+        node = node->children;
+        continue;
+      }
+    }
+    while ((node != top) && (node->next == NULL)) {
+      node = node->parent;
+    }
+    node = (node != top) ? node->next : NULL;
+  }
+  return count > BACKGROUND_FREE_MIN_NODES;
+}
+
+static void freeDocWork(uv_work_t *req) {
+  xmlFreeDoc(static_cast<xmlDoc *>(req->data));
+}
+
+static void freeDocDone(uv_work_t *req, int status) {
+  delete req;
+  // the frees on the worker thread couldn't be reported to v8
+  syncExternalMemory();
+}
+
 XmlDocument::~XmlDocument() {
+  // already freed by dispose()
+  if (xml_obj == NULL) {
+    return;
+  }
+
+  if (xpath_ctxt != NULL) {
+    xmlXPathFreeContext(xpath_ctxt);
+  }
+  delete node_index;
   xml_obj->_private = NULL;
+
+  if (mayFreeInBackground(xml_obj)) {
+    uv_work_t *req = new uv_work_t;
+    req->data = xml_obj;
+    int err = uv_queue_work(Nan::GetCurrentEventLoop(), req, freeDocWork,
+                            freeDocDone);
+    if (err == 0) {
+      return;
+    }
+    delete req;
+  }
   xmlFreeDoc(xml_obj);
 }
 
@@ -793,12 +1947,33 @@ void XmlDocument::Initialize(Local<Object> target) {
   Nan::SetPrototypeMethod(tmpl, "validate", XmlDocument::Validate);
   Nan::SetPrototypeMethod(tmpl, "rngValidate", XmlDocument::RngValidate);
   Nan::SetPrototypeMethod(tmpl, "schematronValidate", XmlDocument::SchematronValidate);
+  Nan::SetPrototypeMethod(tmpl, "_validateAsync", XmlDocument::ValidateAsync);
+  Nan::SetPrototypeMethod(tmpl, "_rngValidateAsync",
+                          XmlDocument::RngValidateAsync);
+  Nan::SetPrototypeMethod(tmpl, "_schematronValidateAsync",
+                          XmlDocument::SchematronValidateAsync);
+  Nan::SetPrototypeMethod(tmpl, "registerXPathNamespaces",
+                          XmlDocument::RegisterXPathNamespaces);
+  Nan::SetPrototypeMethod(tmpl, "buildIndex", XmlDocument::BuildIndex);
+  Nan::SetPrototypeMethod(tmpl, "lookup", XmlDocument::Lookup);
+  Nan::SetPrototypeMethod(tmpl, "getElementById", XmlDocument::GetElementById);
+  Nan::SetPrototypeMethod(tmpl, "getElementsByTagName",
+                          XmlDocument::GetElementsByTagName);
+  Nan::SetPrototypeMethod(tmpl, "querySelector", XmlDocument::QuerySelector);
+  Nan::SetPrototypeMethod(tmpl, "querySelectorAll",
+                          XmlDocument::QuerySelectorAll);
+  Nan::SetPrototypeMethod(tmpl, "toFlatTree", XmlDocument::ToFlatTree);
+  Nan::SetPrototypeMethod(tmpl, "cursor", XmlDocument::Cursor);
+  Nan::SetPrototypeMethod(tmpl, "dispose", XmlDocument::Dispose);
   Nan::SetPrototypeMethod(tmpl, "_setDtd", XmlDocument::SetDtd);
   Nan::SetPrototypeMethod(tmpl, "getDtd", XmlDocument::GetDtd);
   Nan::SetPrototypeMethod(tmpl, "type", XmlDocument::type);
 
   Nan::SetMethod(target, "fromXml", XmlDocument::FromXml);
+  Nan::SetMethod(target, "fromXmlAsync", XmlDocument::FromXmlAsync);
+  Nan::SetMethod(target, "fromObject", XmlDocument::FromObject);
   Nan::SetMethod(target, "fromHtml", XmlDocument::FromHtml);
+  Nan::SetMethod(target, "fromHtmlAsync", XmlDocument::FromHtmlAsync);
 
   // used to create new document handles
   Nan::Set(target, Nan::New<String>("Document").ToLocalChecked(),
@@ -3,11 +3,15 @@
 #define SRC_XML_DOCUMENT_H_
 
 #include <libxml/tree.h>
+#include <libxml/xpath.h>
 
 #include "libxmljs.h"
 
 namespace libxmljs {
 
+class XmlNode;
+class XmlNodeIndex;
+
 class XmlDocument : public Nan::ObjectWrap {
 
 public:
@@ -33,13 +37,68 @@ public:
   // expose ObjectWrap::refs_ (for testing)
   int refs() { return refs_; }
 
+  // number of background jobs (e.g. async validation) currently
+  // reading the document, it must not be modified while any run
+  int background_jobs;
+
+  // why the tree of the given document can't be modified right now,
+  // NULL if it can
+  static const char *ModifyError(xmlDoc *doc);
+
+  // incremented whenever the tree may have changed, anything holding
+  // on to node pointers between calls (e.g. xpath iterators) compares
+  // it to find out whether those are stale
+  unsigned int generation;
+
+  // called once the tree of the given document has changed: nodes were
+  // linked, unlinked or renamed, or content or attributes were set
+  static void TreeChanged(xmlDoc *doc);
+
+  // keep the attribute tables of the index of the document in step:
+  // called once `node` was linked into a tree, when the attributes of
+  // `element` changed, before an element is freed and before `node`
+  // moves to another document
+  static void NodeLinked(xmlNode *node);
+  static void AttributesChanged(xmlNode *element);
+  static void NodeFreed(xmlNode *node);
+  static void NodeLeaving(xmlNode *node);
+
+  // xpath context shared by find() and get() on all nodes of the
+  // document, it holds the namespaces registered with
+  // registerXPathNamespaces() and is NULL until then
+  xmlXPathContext *xpath_ctxt;
+
+  // lookup tables over the elements of the document, created on
+  // first use
+  XmlNodeIndex *index();
+
+  // the index, NULL if it wasn't needed so far
+  XmlNodeIndex *index_if_any() { return node_index; }
+
+  // track the node wrappers created for the tree of the document
+  void add_wrapper(XmlNode *node);
+  void remove_wrapper(XmlNode *node);
+
+  // free the tree right away, leaving all wrappers of the document and
+  // its nodes without a libxml object (xml_obj is NULL)
+  void dispose();
+
+  // getElementsByTagName(name, [nsUri]) of the document, or of the
+  // element `within` when that is not NULL
+  static void
+  elements_by_tag_name(const Nan::FunctionCallbackInfo<v8::Value> &info,
+                       xmlDoc *doc, xmlNode *within);
+
 protected:
   // initialize a new document
   explicit XmlDocument(xmlDoc *doc);
 
   static NAN_METHOD(New);
   static NAN_METHOD(FromHtml);
+  static NAN_METHOD(FromHtmlAsync);
   static NAN_METHOD(FromXml);
+  static NAN_METHOD(FromXmlAsync);
+  static NAN_METHOD(FromObject);
   static NAN_METHOD(SetDtd);
 
   // document handle methods
@@ -53,6 +112,19 @@ protected:
   static NAN_METHOD(Validate);
   static NAN_METHOD(RngValidate);
   static NAN_METHOD(SchematronValidate);
+  static NAN_METHOD(ValidateAsync);
+  static NAN_METHOD(RngValidateAsync);
+  static NAN_METHOD(SchematronValidateAsync);
+  static NAN_METHOD(RegisterXPathNamespaces);
+  static NAN_METHOD(BuildIndex);
+  static NAN_METHOD(Lookup);
+  static NAN_METHOD(GetElementById);
+  static NAN_METHOD(GetElementsByTagName);
+  static NAN_METHOD(QuerySelector);
+  static NAN_METHOD(QuerySelectorAll);
+  static NAN_METHOD(ToFlatTree);
+  static NAN_METHOD(Cursor);
+  static NAN_METHOD(Dispose);
   static NAN_METHOD(type);
 
   // Static member variables
@@ -60,6 +132,12 @@ protected:
   static const int EXCLUDE_IMPLIED_ELEMENTS;
 
   void setEncoding(const char *encoding);
+
+  XmlNodeIndex *node_index;
+
+  // the node wrappers of the document, linked through
+  // XmlNode::next_wrapper
+  XmlNode *wrappers;
 };
 
 } // namespace libxmljs
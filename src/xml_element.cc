@@ -2,14 +2,22 @@
 
 #include <node.h>
 
+#include <cctype>
 #include <cstring>
+#include <map>
+#include <string>
 
 #include "libxmljs.h"
 
 #include "xml_attribute.h"
+#include "xml_css_selector.h"
+#include "xml_cursor.h"
 #include "xml_document.h"
 #include "xml_element.h"
+#include "xml_js_object.h"
+#include "xml_node_index.h"
 #include "xml_xpath_context.h"
+#include "xml_xpath_iterator.h"
 
 using namespace v8;
 
@@ -30,6 +38,8 @@ NAN_METHOD(XmlElement::New) {
   XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(
       Nan::To<Object>(info[0]).ToLocalChecked());
   assert(document);
+  DOCUMENT_DISPOSED_CHECK(document)
+  DOCUMENT_MUTATION_CHECK(document->xml_obj)
 
   Nan::Utf8String name(info[1]);
 
@@ -65,10 +75,12 @@ NAN_METHOD(XmlElement::Name) {
   Nan::HandleScope scope;
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   if (info.Length() == 0)
     return info.GetReturnValue().Set(element->get_name());
 
+  DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
   Nan::Utf8String name(Nan::To<String>(info[0]).ToLocalChecked());
   element->set_name(*name);
   return info.GetReturnValue().Set(info.This());
@@ -78,6 +90,7 @@ NAN_METHOD(XmlElement::Attr) {
   Nan::HandleScope scope;
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   // getter
   if (info.Length() == 1) {
@@ -86,6 +99,7 @@ NAN_METHOD(XmlElement::Attr) {
   }
 
   // setter
+  DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
   Nan::Utf8String name(info[0]);
   Nan::Utf8String value(info[1]);
   element->set_attr(*name, *value);
@@ -93,21 +107,149 @@ NAN_METHOD(XmlElement::Attr) {
   return info.GetReturnValue().Set(info.This());
 }
 
+// {name: value}
+NAN_METHOD(XmlElement::SetAttributes) {
+  Nan::HandleScope scope;
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsObject,
+                               "Bad argument: attributes must be an object");
+  DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
+
+  Local<Object> attributes = Nan::To<Object>(info[0]).ToLocalChecked();
+  Local<Array> names = Nan::GetPropertyNames(attributes).ToLocalChecked();
+  for (unsigned int i = 0; i < names->Length(); i++) {
+    Local<Value> name = Nan::Get(names, i).ToLocalChecked();
+    Nan::Utf8String attr_name(name);
+    Nan::Utf8String value(Nan::Get(attributes, name).ToLocalChecked());
+    element->set_attr(*attr_name, *value);
+  }
+
+  return info.GetReturnValue().Set(info.This());
+}
+
 NAN_METHOD(XmlElement::Attrs) {
   Nan::HandleScope scope;
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   return info.GetReturnValue().Set(element->get_attrs());
 }
 
+// {name: value} of all attributes, prefixed names for namespaced ones
+NAN_METHOD(XmlElement::AttrsObject) {
+  Nan::HandleScope scope;
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+
+  Local<Object> attributes = Nan::New<Object>();
+  for (xmlAttr *attr = element->xml_obj->properties; attr != NULL;
+       attr = attr->next) {
+    Local<String> name;
+    if ((attr->ns != NULL) && (attr->ns->prefix != NULL)) {
+      std::string qname((const char *)attr->ns->prefix);
+      qname += ':';
+      qname += (const char *)attr->name;
+      name = Nan::New<String>(qname).ToLocalChecked();
+    } else {
+      name = Nan::New<String>((const char *)attr->name).ToLocalChecked();
+    }
+    // defined rather than assigned, in case of a __proto__ attribute
+    Nan::DefineOwnProperty(attributes, name, XmlAttribute::value_of(attr));
+  }
+
+  return info.GetReturnValue().Set(attributes);
+}
+
+// the value of the named attribute, null when there is none
+NAN_METHOD(XmlElement::GetAttribute) {
+  Nan::HandleScope scope;
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsString,
+                               "Bad argument: name must be a string");
+  Nan::Utf8String name(info[0]);
+
+  return info.GetReturnValue().Set(
+      attribute_value(element->xml_obj, (const xmlChar *)*name));
+}
+
+Local<Value> XmlElement::attribute_value(xmlNode *element,
+                                         const xmlChar *name) {
+  Nan::EscapableHandleScope scope;
+
+  xmlAttr *attr = xmlHasProp(element, name);
+  if (attr == NULL) {
+    return scope.Escape(Nan::Null());
+  }
+
+  // defaults from the dtd come back as the declaration
+  if (attr->type == XML_ATTRIBUTE_DECL) {
+    const xmlChar *value =
+        reinterpret_cast<xmlAttribute *>(attr)->defaultValue;
+    return scope.Escape(
+        Nan::New<String>(value ? (const char *)value : "").ToLocalChecked());
+  }
+
+  return scope.Escape(XmlAttribute::value_of(attr));
+}
+
+// [{attributePrefix, textKey, alwaysArray, namespaces}]
+NAN_METHOD(XmlElement::ToObject) {
+  Nan::HandleScope scope;
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+
+  XmlToObject converter;
+  if (!converter.set_options(info[0])) {
+    return;
+  }
+
+  return info.GetReturnValue().Set(converter.convert(element->xml_obj));
+}
+
+// {name: content}, [{attributePrefix, textKey}]
+NAN_METHOD(XmlElement::AppendObject) {
+  Nan::HandleScope scope;
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+  DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
+
+  // the nodes added follow the current last child
+  xmlNode *last = element->xml_obj->last;
+
+  XmlFromObject builder;
+  if (!builder.set_options(info[1]) ||
+      !builder.append(element->xml_obj, info[0])) {
+    return;
+  }
+  XmlDocument::TreeChanged(element->xml_obj->doc);
+  xmlNode *added = (last != NULL) ? last->next : element->xml_obj->children;
+  for (; added != NULL; added = added->next) {
+    XmlDocument::NodeLinked(added);
+  }
+
+  return info.GetReturnValue().Set(info.This());
+}
+
 NAN_METHOD(XmlElement::AddChild) {
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
+  DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
 
   XmlNode *child = Nan::ObjectWrap::Unwrap<XmlNode>(
       Nan::To<Object>(info[0]).ToLocalChecked());
   assert(child);
+  NODE_DISPOSED_CHECK(child)
 
   xmlNode *imported_child = element->import_node(child->xml_obj);
   if (imported_child == NULL) {
@@ -123,10 +265,6 @@ NAN_METHOD(XmlElement::AddChild) {
 
   element->add_child(imported_child);
 
-  if (!will_merge && (imported_child->_private != NULL)) {
-    static_cast<XmlNode *>(imported_child->_private)->ref_wrapped_ancestor();
-  }
-
   return info.GetReturnValue().Set(info.This());
 }
 
@@ -134,6 +272,8 @@ NAN_METHOD(XmlElement::AddCData) {
   Nan::HandleScope scope;
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
+  DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
 
   Local<Value> contentOpt;
   if (info[0]->IsString()) {
@@ -150,42 +290,369 @@ NAN_METHOD(XmlElement::AddCData) {
   return info.GetReturnValue().Set(info.This());
 }
 
-NAN_METHOD(XmlElement::Find) {
+// register the optional arguments of
+// find(xpath, [ns_uri|namespaces], [variables]) and friends
+static bool setupXPathContext(XmlXpathContext &ctxt,
+                              const Nan::FunctionCallbackInfo<Value> &info) {
+  if (info.Length() > 1) {
+    ctxt.register_namespaces(info[1]);
+  }
+  if (info.Length() > 2) {
+    return ctxt.register_variables(info[2]);
+  }
+  return true;
+}
+
+// the name of "//name" expressions, which select every element of
+// that name without a namespace, NULL for any other expression
+static const char *descendantNameTest(const char *xpath) {
+  if ((xpath[0] != '/') || (xpath[1] != '/')) {
+    return NULL;
+  }
+  const char *name = xpath + 2;
+  if (!isalpha(static_cast<unsigned char>(*name)) && (*name != '_')) {
+    return NULL;
+  }
+  for (const char *c = name + 1; *c != '\0'; c++) {
+    if (!isalnum(static_cast<unsigned char>(*c)) && (*c != '_') &&
+        (*c != '-') && (*c != '.')) {
+      return NULL;
+    }
+  }
+  return name;
+}
+
+// answer "//name" from the tag name index of the document, returns
+// false when the query must be evaluated as xpath
+static bool findByTagName(const Nan::FunctionCallbackInfo<Value> &info,
+                          xmlNode *node, XmlXpathContext::ResultMode mode) {
+  if (((mode != XmlXpathContext::RESULT_NODES) &&
+       (mode != XmlXpathContext::RESULT_COUNT)) ||
+      !info[0]->IsString() || (node->doc == NULL) ||
+      (node->doc->_private == NULL)) {
+    return false;
+  }
+
+  Nan::Utf8String xpath(info[0]);
+  const char *name = descendantNameTest(*xpath);
+  if (name == NULL) {
+    return false;
+  }
+
+  // libxml starts "//" from the document even for removed nodes
+  XmlDocument *document = static_cast<XmlDocument *>(node->doc->_private);
+  std::vector<xmlNode *> found;
+  document->index()->find_elements((const xmlChar *)name, NULL, false, NULL,
+                                   document->generation, found);
+
+  if (mode == XmlXpathContext::RESULT_COUNT) {
+    info.GetReturnValue().Set(
+        Nan::New<Number>(static_cast<double>(found.size())));
+    return true;
+  }
+
+  Local<Array> elements = Nan::New<Array>(static_cast<int>(found.size()));
+  for (size_t i = 0; i < found.size(); i++) {
+    Nan::Set(elements, i, XmlElement::New(found[i]));
+  }
+  info.GetReturnValue().Set(elements);
+  return true;
+}
+
+// xpath, [ns_uri|namespaces], [variables]
+static void evaluateXPath(const Nan::FunctionCallbackInfo<Value> &info,
+                          XmlXpathContext::ResultMode mode) {
   Nan::HandleScope scope;
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
-  Nan::Utf8String xpath(info[0]);
+  if (findByTagName(info, element->xml_obj, mode)) {
+    return;
+  }
 
   XmlXpathContext ctxt(element->xml_obj);
+  if (!setupXPathContext(ctxt, info)) {
+    return;
+  }
+
+  return info.GetReturnValue().Set(ctxt.evaluate(info[0], mode));
+}
+
+NAN_METHOD(XmlElement::Find) {
+  evaluateXPath(info, XmlXpathContext::RESULT_NODES);
+}
+
+NAN_METHOD(XmlElement::FindStrings) {
+  evaluateXPath(info, XmlXpathContext::RESULT_STRINGS);
+}
+
+NAN_METHOD(XmlElement::FindAttrValues) {
+  evaluateXPath(info, XmlXpathContext::RESULT_ATTR_VALUES);
+}
+
+NAN_METHOD(XmlElement::Count) {
+  evaluateXPath(info, XmlXpathContext::RESULT_COUNT);
+}
 
-  if (info.Length() == 2) {
-    if (info[1]->IsString()) {
-      Nan::Utf8String uri(info[1]);
-      ctxt.register_ns((const xmlChar *)"xmlns", (const xmlChar *)*uri);
-    } else if (info[1]->IsObject()) {
-      Local<Object> namespaces = Nan::To<Object>(info[1]).ToLocalChecked();
-      Local<Array> properties =
-          Nan::GetPropertyNames(namespaces).ToLocalChecked();
-      for (unsigned int i = 0; i < properties->Length(); i++) {
-        Local<String> prop_name =
-            Nan::To<String>(
-                Nan::Get(properties, Nan::New<Number>(i)).ToLocalChecked())
-                .ToLocalChecked();
-        Nan::Utf8String prefix(prop_name);
-        Nan::Utf8String uri(Nan::Get(namespaces, prop_name).ToLocalChecked());
-        ctxt.register_ns((const xmlChar *)*prefix, (const xmlChar *)*uri);
+// xpath, [ns_uri|namespaces], [variables]
+NAN_METHOD(XmlElement::Iterate) {
+  Nan::HandleScope scope;
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+
+  XmlXpathContext ctxt(element->xml_obj);
+  if (!setupXPathContext(ctxt, info)) {
+    return;
+  }
+
+  xmlXPathObject *result = ctxt.evaluate_object(info[0]);
+  if (result == NULL) {
+    return Nan::ThrowError("Could not evaluate XPath expression");
+  }
+  if (result->type != XPATH_NODESET) {
+    xmlXPathFreeObject(result);
+    return Nan::ThrowError("XPath expression must select a node set");
+  }
+
+  XmlDocument *document =
+      static_cast<XmlDocument *>(element->xml_obj->doc->_private);
+  return info.GetReturnValue().Set(
+      XmlXPathIterator::New(result, document, info.This()));
+}
+
+// name, [nsUri]
+NAN_METHOD(XmlElement::GetElementsByTagName) {
+  Nan::HandleScope scope;
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+
+  if ((element->xml_obj->doc == NULL) ||
+      (element->xml_obj->doc->_private == NULL)) {
+    return info.GetReturnValue().Set(Nan::New<Array>(0));
+  }
+  XmlDocument::elements_by_tag_name(info, element->xml_obj->doc,
+                                    element->xml_obj);
+}
+
+// selector
+NAN_METHOD(XmlElement::QuerySelector) {
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+
+  XmlCssSelector::query(info, element->xml_obj, false);
+}
+
+// selector
+NAN_METHOD(XmlElement::QuerySelectorAll) {
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+
+  XmlCssSelector::query(info, element->xml_obj, true);
+}
+
+NAN_METHOD(XmlElement::Cursor) {
+  Nan::HandleScope scope;
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+
+  XmlDocument *document =
+      (element->xml_obj->doc != NULL)
+          ? static_cast<XmlDocument *>(element->xml_obj->doc->_private)
+          : NULL;
+  return info.GetReturnValue().Set(
+      XmlCursor::New(element->xml_obj, document, info.This()));
+}
+
+// visitor, [{types, maxDepth}]
+NAN_METHOD(XmlElement::Walk) {
+  Nan::HandleScope scope;
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsFunction,
+                               "Bad argument: visitor must be a function");
+  Local<Function> visitor = info[0].As<Function>();
+
+  // bit n is set for the node types visited, all of them when 0
+  uint32_t types = 0;
+  int32_t max_depth = -1;
+  if ((info.Length() > 1) && !info[1]->IsNullOrUndefined()) {
+    LIBXMLJS_ARGUMENT_TYPE_CHECK(info[1], IsObject,
+                                 "Bad argument: options must be an object");
+    Local<Object> options = info[1].As<Object>();
+
+    Local<Value> type_list =
+        Nan::Get(options, Nan::New<String>("types").ToLocalChecked())
+            .ToLocalChecked();
+    if (!type_list->IsUndefined()) {
+      if (!type_list->IsArray()) {
+        return Nan::ThrowTypeError(
+            "Bad argument: types must be an array of node types");
+      }
+      Local<Array> list = type_list.As<Array>();
+      for (uint32_t i = 0; i < list->Length(); i++) {
+        Local<Value> type = Nan::Get(list, i).ToLocalChecked();
+        if (!type->IsUint32() || (Nan::To<uint32_t>(type).FromJust() > 31)) {
+          return Nan::ThrowTypeError(
+              "Bad argument: types must be an array of node types");
+        }
+        types |= 1u << Nan::To<uint32_t>(type).FromJust();
+      }
+    }
+
+    Local<Value> limit =
+        Nan::Get(options, Nan::New<String>("maxDepth").ToLocalChecked())
+            .ToLocalChecked();
+    if (!limit->IsUndefined()) {
+      if (!limit->IsInt32() || (Nan::To<int32_t>(limit).FromJust() < 0)) {
+        return Nan::ThrowTypeError(
+            "Bad argument: maxDepth must be a non-negative integer");
+      }
+      max_depth = Nan::To<int32_t>(limit).FromJust();
+    }
+  }
+
+  xmlNode *top = element->xml_obj;
+  XmlDocument *document =
+      (top->doc != NULL) ? static_cast<XmlDocument *>(top->doc->_private)
+                         : NULL;
+  unsigned int generation = (document != NULL) ? document->generation : 0;
+
+  // the visitor gets the same cursor for every node, so nodes are only
+  // wrapped when it calls node()
+  Local<Object> cursor_obj = XmlCursor::New(top, document, info.This());
+  XmlCursor *cursor = Nan::ObjectWrap::Unwrap<XmlCursor>(cursor_obj);
+
+  // names from the dictionary of the document are created only once
+  xmlDict *dict = (top->doc != NULL) ? top->doc->dict : NULL;
+  std::map<const xmlChar *, Local<String>> names;
+
+  xmlNode *node = top;
+  int32_t depth = 0;
+  while (node != NULL) {
+    bool descend = (node->type == XML_ELEMENT_NODE) &&
+                   ((max_depth < 0) || (depth < max_depth));
+
+    if ((types == 0) || (types & (1u << node->type))) {
+      bool named = (node->name != NULL) &&
+                   ((node->type == XML_ELEMENT_NODE) ||
+                    (node->type == XML_PI_NODE) ||
+                    (node->type == XML_ENTITY_REF_NODE));
+      Local<String> name;
+      if (named && (dict != NULL) && xmlDictOwns(dict, node->name)) {
+        Local<String> &cached = names[node->name];
+        if (cached.IsEmpty()) {
+          cached = Nan::New<String>((const char *)node->name).ToLocalChecked();
+        }
+        name = cached;
+      }
+
+      Nan::HandleScope call_scope;
+      Local<Value> name_value = Nan::Null();
+      if (!name.IsEmpty()) {
+        name_value = name;
+      } else if (named) {
+        name_value =
+            Nan::New<String>((const char *)node->name).ToLocalChecked();
+      }
+
+      cursor->move(node);
+      Local<Value> argv[4] = {name_value, Nan::New<Int32>(node->type),
+                              Nan::New<Int32>(depth), cursor_obj};
+      Nan::MaybeLocal<Value> result = Nan::Call(
+          visitor, Nan::GetCurrentContext()->Global(), 4, argv);
+      if (result.IsEmpty()) {
+        // the visitor threw
+        return;
       }
+      if ((document != NULL) && (document->generation != generation)) {
+        return Nan::ThrowError("Document was modified during walk");
+      }
+      if (result.ToLocalChecked()->IsFalse()) {
+        descend = false;
+      }
+    }
+
+    // on to the next node in document order
+    if (descend && (node->children != NULL)) {
+      node = node->children;
+      depth++;
+      continue;
+    }
+    while ((node != top) && (node->next == NULL)) {
+      node = node->parent;
+      depth--;
     }
+    node = (node != top) ? node->next : NULL;
   }
+}
 
-  return info.GetReturnValue().Set(ctxt.evaluate((const xmlChar *)*xpath));
+// {field: xpath}, {as: 'string'|'number'|'nodes', namespaces, variables}
+NAN_METHOD(XmlElement::EvaluateMany) {
+  Nan::HandleScope scope;
+  XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
+  assert(element);
+  NODE_DISPOSED_CHECK(element)
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsObject,
+                               "Bad argument: expressions must be an object");
+
+  XmlXpathContext ctxt(element->xml_obj);
+  XmlXpathContext::ResultMode mode = XmlXpathContext::RESULT_STRING;
+
+  if (info.Length() > 1 && info[1]->IsObject()) {
+    Local<Object> options = Nan::To<Object>(info[1]).ToLocalChecked();
+
+    Local<Value> as =
+        Nan::Get(options, Nan::New<String>("as").ToLocalChecked())
+            .ToLocalChecked();
+    if (!as->IsUndefined()) {
+      Nan::Utf8String as_str(as);
+      if (strcmp(*as_str, "number") == 0) {
+        mode = XmlXpathContext::RESULT_NUMBER;
+      } else if (strcmp(*as_str, "nodes") == 0) {
+        mode = XmlXpathContext::RESULT_NODES;
+      } else if (strcmp(*as_str, "string") != 0) {
+        return Nan::ThrowError(
+            "Bad argument: as must be 'string', 'number' or 'nodes'");
+      }
+    }
+
+    ctxt.register_namespaces(
+        Nan::Get(options, Nan::New<String>("namespaces").ToLocalChecked())
+            .ToLocalChecked());
+    if (!ctxt.register_variables(
+            Nan::Get(options, Nan::New<String>("variables").ToLocalChecked())
+                .ToLocalChecked())) {
+      return;
+    }
+  }
+
+  Local<Object> expressions = Nan::To<Object>(info[0]).ToLocalChecked();
+  Local<Array> fields = Nan::GetPropertyNames(expressions).ToLocalChecked();
+  Local<Object> results = Nan::New<Object>();
+  for (unsigned int i = 0; i < fields->Length(); i++) {
+    Local<Value> field = Nan::Get(fields, i).ToLocalChecked();
+    Nan::Set(results, field,
+             ctxt.evaluate(Nan::Get(expressions, field).ToLocalChecked(),
+                           mode));
+  }
+
+  return info.GetReturnValue().Set(results);
 }
 
 NAN_METHOD(XmlElement::NextElement) {
   Nan::HandleScope scope;
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   return info.GetReturnValue().Set(element->get_next_element());
 }
@@ -194,6 +661,7 @@ NAN_METHOD(XmlElement::PrevElement) {
   Nan::HandleScope scope;
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   return info.GetReturnValue().Set(element->get_prev_element());
 }
@@ -202,10 +670,12 @@ NAN_METHOD(XmlElement::Text) {
   Nan::HandleScope scope;
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   if (info.Length() == 0) {
     return info.GetReturnValue().Set(element->get_content());
   } else {
+    DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
     element->set_content(*Nan::Utf8String(info[0]));
   }
 
@@ -216,6 +686,7 @@ NAN_METHOD(XmlElement::Child) {
   Nan::HandleScope scope;
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   if (info.Length() != 1 || !info[0]->IsInt32()) {
     return Nan::ThrowError("Bad argument: must provide #child() with a number");
@@ -229,6 +700,7 @@ NAN_METHOD(XmlElement::ChildNodes) {
   Nan::HandleScope scope;
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   if (info[0]->IsInt32())
     return info.GetReturnValue().Set(
@@ -241,6 +713,7 @@ NAN_METHOD(XmlElement::Path) {
   Nan::HandleScope scope;
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   return info.GetReturnValue().Set(element->get_path());
 }
@@ -248,10 +721,13 @@ NAN_METHOD(XmlElement::Path) {
 NAN_METHOD(XmlElement::AddPrevSibling) {
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
+  DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
 
   XmlNode *new_sibling = Nan::ObjectWrap::Unwrap<XmlNode>(
       Nan::To<Object>(info[0]).ToLocalChecked());
   assert(new_sibling);
+  NODE_DISPOSED_CHECK(new_sibling)
 
   xmlNode *imported_sibling = element->import_node(new_sibling->xml_obj);
   if (imported_sibling == NULL) {
@@ -261,20 +737,19 @@ NAN_METHOD(XmlElement::AddPrevSibling) {
 
   element->add_prev_sibling(imported_sibling);
 
-  if (imported_sibling->_private != NULL) {
-    static_cast<XmlNode *>(imported_sibling->_private)->ref_wrapped_ancestor();
-  }
-
   return info.GetReturnValue().Set(info[0]);
 }
 
 NAN_METHOD(XmlElement::AddNextSibling) {
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
+  DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
 
   XmlNode *new_sibling = Nan::ObjectWrap::Unwrap<XmlNode>(
       Nan::To<Object>(info[0]).ToLocalChecked());
   assert(new_sibling);
+  NODE_DISPOSED_CHECK(new_sibling)
 
   xmlNode *imported_sibling = element->import_node(new_sibling->xml_obj);
   if (imported_sibling == NULL) {
@@ -284,16 +759,14 @@ NAN_METHOD(XmlElement::AddNextSibling) {
 
   element->add_next_sibling(imported_sibling);
 
-  if (imported_sibling->_private != NULL) {
-    static_cast<XmlNode *>(imported_sibling->_private)->ref_wrapped_ancestor();
-  }
-
   return info.GetReturnValue().Set(info[0]);
 }
 
 NAN_METHOD(XmlElement::Replace) {
   XmlElement *element = Nan::ObjectWrap::Unwrap<XmlElement>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
+  DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
 
   if (info[0]->IsString()) {
     element->replace_text(*Nan::Utf8String(info[0]));
@@ -301,6 +774,7 @@ NAN_METHOD(XmlElement::Replace) {
     XmlElement *new_sibling = Nan::ObjectWrap::Unwrap<XmlElement>(
         Nan::To<Object>(info[0]).ToLocalChecked());
     assert(new_sibling);
+    NODE_DISPOSED_CHECK(new_sibling)
 
     xmlNode *imported_sibling = element->import_node(new_sibling->xml_obj);
     if (imported_sibling == NULL) {
@@ -315,6 +789,7 @@ NAN_METHOD(XmlElement::Replace) {
 
 void XmlElement::set_name(const char *name) {
   xmlNodeSetName(xml_obj, (const xmlChar *)name);
+  XmlDocument::TreeChanged(xml_obj->doc);
 }
 
 Local<Value> XmlElement::get_name() {
@@ -341,31 +816,32 @@ Local<Value> XmlElement::get_attr(const char *name) {
 
 // TODO(sprsquish) make these work with namespaces
 void XmlElement::set_attr(const char *name, const char *value) {
-  Nan::HandleScope scope;
-  XmlAttribute::New(xml_obj, (const xmlChar *)name, (const xmlChar *)value);
+  xmlSetProp(xml_obj, (const xmlChar *)name, (const xmlChar *)value);
+  XmlDocument::TreeChanged(xml_obj->doc);
+  XmlDocument::AttributesChanged(xml_obj);
 }
 
 Local<Value> XmlElement::get_attrs() {
   Nan::EscapableHandleScope scope;
   xmlAttr *attr = xml_obj->properties;
 
-  if (!attr)
-    return scope.Escape(Nan::New<Array>(0));
+  int length = 0;
+  for (xmlAttr *cur = attr; cur != NULL; cur = cur->next) {
+    length++;
+  }
 
-  Local<Array> attributes = Nan::New<Array>();
-  Local<Function> push = Local<Function>::Cast(
-      Nan::Get(attributes, Nan::New<String>("push").ToLocalChecked())
-          .ToLocalChecked());
-  Local<Value> argv[1];
-  do {
-    argv[0] = XmlAttribute::New(attr);
-    Nan::Call(push, attributes, 1, argv);
-  } while ((attr = attr->next));
+  Local<Array> attributes = Nan::New<Array>(length);
+  for (int i = 0; attr != NULL; attr = attr->next, i++) {
+    Nan::Set(attributes, i, XmlAttribute::New(attr));
+  }
 
   return scope.Escape(attributes);
 }
 
-void XmlElement::add_cdata(xmlNode *cdata) { xmlAddChild(xml_obj, cdata); }
+void XmlElement::add_cdata(xmlNode *cdata) {
+  xmlAddChild(xml_obj, cdata);
+  XmlDocument::TreeChanged(xml_obj->doc);
+}
 
 Local<Value> XmlElement::get_child(int32_t idx) {
   Nan::EscapableHandleScope scope;
@@ -417,14 +893,22 @@ Local<Value> XmlElement::get_path() {
   return scope.Escape(js_obj);
 }
 
+// children with wrapped nodes in them live on as trees of their own,
+// the others are freed
 void XmlElement::unlink_children() {
+  Nan::HandleScope scope;
   xmlNode *cur = xml_obj->children;
   while (cur != NULL) {
     xmlNode *next = cur->next;
-    if (cur->_private != NULL) {
-      static_cast<XmlNode *>(cur->_private)->unref_wrapped_ancestor();
+    bool wrapped = (wrapped_subtree(cur) > 0);
+    if (wrapped && (cur->_private == NULL)) {
+      XmlNode::New(cur);
     }
+    unlink_wrapped(cur);
     xmlUnlinkNode(cur);
+    if (!wrapped) {
+      xmlFreeNode(cur);
+    }
     cur = next;
   }
 }
@@ -435,6 +919,7 @@ void XmlElement::set_content(const char *content) {
   this->unlink_children();
   xmlNodeSetContent(xml_obj, encoded);
   xmlFree(encoded);
+  XmlDocument::TreeChanged(xml_obj->doc);
 }
 
 Local<Value> XmlElement::get_content() {
@@ -502,17 +987,11 @@ Local<Object> XmlElement::New(xmlNode *node) {
 
 XmlElement::XmlElement(xmlNode *node) : XmlNode(node) {}
 
-void XmlElement::replace_element(xmlNode *element) {
-  xmlReplaceNode(xml_obj, element);
-  if (element->_private != NULL) {
-    XmlNode *node = static_cast<XmlNode *>(element->_private);
-    node->ref_wrapped_ancestor();
-  }
-}
+void XmlElement::replace_element(xmlNode *element) { replace_node(element); }
 
 void XmlElement::replace_text(const char *content) {
   xmlNodePtr txt = xmlNewDocText(xml_obj->doc, (const xmlChar *)content);
-  xmlReplaceNode(xml_obj, txt);
+  replace_node(txt);
 }
 
 bool XmlElement::child_will_merge(xmlNode *child) {
@@ -535,6 +1014,11 @@ void XmlElement::Initialize(Local<Object> target) {
   Nan::SetPrototypeMethod(tmpl, "_attr", XmlElement::Attr);
 
   Nan::SetPrototypeMethod(tmpl, "attrs", XmlElement::Attrs);
+  Nan::SetPrototypeMethod(tmpl, "setAttributes", XmlElement::SetAttributes);
+  Nan::SetPrototypeMethod(tmpl, "attrsObject", XmlElement::AttrsObject);
+  Nan::SetPrototypeMethod(tmpl, "getAttribute", XmlElement::GetAttribute);
+  Nan::SetPrototypeMethod(tmpl, "toObject", XmlElement::ToObject);
+  Nan::SetPrototypeMethod(tmpl, "appendObject", XmlElement::AppendObject);
 
   Nan::SetPrototypeMethod(tmpl, "child", XmlElement::Child);
 
@@ -542,6 +1026,23 @@ void XmlElement::Initialize(Local<Object> target) {
 
   Nan::SetPrototypeMethod(tmpl, "find", XmlElement::Find);
 
+  Nan::SetPrototypeMethod(tmpl, "findStrings", XmlElement::FindStrings);
+
+  Nan::SetPrototypeMethod(tmpl, "findAttrValues", XmlElement::FindAttrValues);
+
+  Nan::SetPrototypeMethod(tmpl, "count", XmlElement::Count);
+
+  Nan::SetPrototypeMethod(tmpl, "iterate", XmlElement::Iterate);
+
+  Nan::SetPrototypeMethod(tmpl, "evaluateMany", XmlElement::EvaluateMany);
+  Nan::SetPrototypeMethod(tmpl, "getElementsByTagName",
+                          XmlElement::GetElementsByTagName);
+  Nan::SetPrototypeMethod(tmpl, "querySelector", XmlElement::QuerySelector);
+  Nan::SetPrototypeMethod(tmpl, "querySelectorAll",
+                          XmlElement::QuerySelectorAll);
+  Nan::SetPrototypeMethod(tmpl, "cursor", XmlElement::Cursor);
+  Nan::SetPrototypeMethod(tmpl, "walk", XmlElement::Walk);
+
   Nan::SetPrototypeMethod(tmpl, "nextElement", XmlElement::NextElement);
 
   Nan::SetPrototypeMethod(tmpl, "prevElement", XmlElement::PrevElement);
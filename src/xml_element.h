@@ -18,12 +18,32 @@ public:
   // create new xml element to wrap the node
   static v8::Local<v8::Object> New(xmlNode *node);
 
+  // the value of the named attribute of the element as a string, null
+  // when there is none
+  static v8::Local<v8::Value> attribute_value(xmlNode *element,
+                                              const xmlChar *name);
+
 protected:
   static NAN_METHOD(New);
   static NAN_METHOD(Name);
   static NAN_METHOD(Attr);
   static NAN_METHOD(Attrs);
+  static NAN_METHOD(SetAttributes);
+  static NAN_METHOD(AttrsObject);
+  static NAN_METHOD(GetAttribute);
+  static NAN_METHOD(ToObject);
+  static NAN_METHOD(AppendObject);
   static NAN_METHOD(Find);
+  static NAN_METHOD(FindStrings);
+  static NAN_METHOD(FindAttrValues);
+  static NAN_METHOD(Count);
+  static NAN_METHOD(Iterate);
+  static NAN_METHOD(EvaluateMany);
+  static NAN_METHOD(GetElementsByTagName);
+  static NAN_METHOD(QuerySelector);
+  static NAN_METHOD(QuerySelectorAll);
+  static NAN_METHOD(Cursor);
+  static NAN_METHOD(Walk);
   static NAN_METHOD(Text);
   static NAN_METHOD(Path);
   static NAN_METHOD(Child);
@@ -0,0 +1,504 @@
+// Copyright 2009, Squish Tech, LLC.
+
+#include <node_buffer.h>
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "xml_attribute.h"
+#include "xml_js_object.h"
+
+using namespace v8;
+
+namespace libxmljs {
+
+// read the string option `name` into value, unless it is undefined
+static bool readStringOption(Local<Object> options, const char *name,
+                             std::string &value) {
+  Local<Value> option =
+      Nan::Get(options, Nan::New<String>(name).ToLocalChecked())
+          .ToLocalChecked();
+  if (option->IsString()) {
+    value = *Nan::Utf8String(option);
+  } else if (!option->IsUndefined()) {
+    Nan::ThrowTypeError(
+        (std::string("Bad argument: ") + name + " must be a string").c_str());
+    return false;
+  }
+  return true;
+}
+
+XmlToObject::XmlToObject()
+    : attribute_prefix("@"), text_key("#text"), namespaces(NS_PREFIX),
+      all_arrays(false) {}
+
+// {attributePrefix, textKey, alwaysArray, namespaces}
+bool XmlToObject::set_options(Local<Value> options) {
+  if (options->IsNullOrUndefined()) {
+    return true;
+  }
+  if (!options->IsObject()) {
+    Nan::ThrowTypeError("Bad argument: options must be an object");
+    return false;
+  }
+  Local<Object> opts = Nan::To<Object>(options).ToLocalChecked();
+
+  if (!readStringOption(opts, "attributePrefix", attribute_prefix) ||
+      !readStringOption(opts, "textKey", text_key)) {
+    return false;
+  }
+
+  Local<Value> arrays =
+      Nan::Get(opts, Nan::New<String>("alwaysArray").ToLocalChecked())
+          .ToLocalChecked();
+  if (arrays->IsBoolean()) {
+    all_arrays = Nan::To<bool>(arrays).FromJust();
+  } else if (arrays->IsArray()) {
+    Local<Array> names = Local<Array>::Cast(arrays);
+    for (unsigned int i = 0; i < names->Length(); i++) {
+      array_names.insert(
+          *Nan::Utf8String(Nan::Get(names, i).ToLocalChecked()));
+    }
+  } else if (!arrays->IsUndefined()) {
+    Nan::ThrowTypeError(
+        "Bad argument: alwaysArray must be a boolean or an array of names");
+    return false;
+  }
+
+  Local<Value> mode =
+      Nan::Get(opts, Nan::New<String>("namespaces").ToLocalChecked())
+          .ToLocalChecked();
+  if (!mode->IsUndefined()) {
+    std::string name = mode->IsString() ? *Nan::Utf8String(mode) : "";
+    if (name == "prefix") {
+      namespaces = NS_PREFIX;
+    } else if (name == "local") {
+      namespaces = NS_LOCAL;
+    } else if (name == "uri") {
+      namespaces = NS_URI;
+    } else {
+      Nan::ThrowTypeError(
+          "Bad argument: namespaces must be 'prefix', 'local' or 'uri'");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+Local<String> XmlToObject::key(xmlNs *ns, const xmlChar *name,
+                               bool attribute) {
+  if (namespaces == NS_LOCAL) {
+    ns = NULL;
+  }
+
+  std::pair<std::pair<xmlNs *, const xmlChar *>, bool> id(
+      std::make_pair(ns, name), attribute);
+  std::map<std::pair<std::pair<xmlNs *, const xmlChar *>, bool>,
+           Local<String>>::iterator found = keys.find(id);
+  if (found != keys.end()) {
+    return found->second;
+  }
+
+  std::string key = attribute ? attribute_prefix : "";
+  if ((ns != NULL) && (namespaces == NS_URI) && (ns->href != NULL)) {
+    key += '{';
+    key += (const char *)ns->href;
+    key += '}';
+  } else if ((ns != NULL) && (namespaces == NS_PREFIX) &&
+             (ns->prefix != NULL)) {
+    key += (const char *)ns->prefix;
+    key += ':';
+  }
+  key += (const char *)name;
+
+  Local<String> value = Nan::New<String>(key).ToLocalChecked();
+  keys[id] = value;
+  return value;
+}
+
+bool XmlToObject::always_array(const xmlChar *name) {
+  return all_arrays ||
+         (!array_names.empty() &&
+          array_names.count(reinterpret_cast<const char *>(name)) != 0);
+}
+
+Local<Value> XmlToObject::convert(xmlNode *element) {
+  std::string text;
+  bool has_elements = false;
+
+  for (xmlNode *child = element->children; child != NULL;
+       child = child->next) {
+    switch (child->type) {
+    case XML_ELEMENT_NODE:
+      has_elements = true;
+      break;
+    case XML_TEXT_NODE:
+    case XML_CDATA_SECTION_NODE:
+      if (child->content != NULL) {
+        text += (const char *)child->content;
+      }
+      break;
+    case XML_ENTITY_REF_NODE: {
+      xmlChar *content = xmlNodeGetContent(child);
+      if (content != NULL) {
+        text += (const char *)content;
+        xmlFree(content);
+      }
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  if (!has_elements && (element->properties == NULL)) {
+    return Nan::New<String>(text).ToLocalChecked();
+  }
+
+  Local<Object> object = Nan::New<Object>();
+
+  // keys are defined rather than assigned, so names like __proto__
+  // end up as plain properties
+  for (xmlAttr *attr = element->properties; attr != NULL; attr = attr->next) {
+    Nan::DefineOwnProperty(object, key(attr->ns, attr->name, true),
+                           XmlAttribute::value_of(attr));
+  }
+
+  for (xmlNode *child = element->children; has_elements && child != NULL;
+       child = child->next) {
+    if (child->type != XML_ELEMENT_NODE) {
+      continue;
+    }
+
+    Local<String> name = key(child->ns, child->name, false);
+    Local<Value> value = convert(child);
+
+    // repeated names are collected into arrays, values are never
+    // arrays otherwise
+    if (Nan::HasOwnProperty(object, name).FromJust()) {
+      Local<Value> existing = Nan::Get(object, name).ToLocalChecked();
+      if (existing->IsArray()) {
+        Local<Array> values = Local<Array>::Cast(existing);
+        Nan::Set(values, values->Length(), value);
+      } else {
+        Local<Array> values = Nan::New<Array>(2);
+        Nan::Set(values, 0, existing);
+        Nan::Set(values, 1, value);
+        Nan::DefineOwnProperty(object, name, values);
+      }
+    } else if (always_array(child->name)) {
+      Local<Array> values = Nan::New<Array>(1);
+      Nan::Set(values, 0, value);
+      Nan::DefineOwnProperty(object, name, values);
+    } else {
+      Nan::DefineOwnProperty(object, name, value);
+    }
+  }
+
+  // whitespace between child elements is formatting
+  if (text.find_first_not_of(" \t\r\n") != std::string::npos) {
+    Nan::DefineOwnProperty(object, Nan::New<String>(text_key).ToLocalChecked(),
+                           Nan::New<String>(text).ToLocalChecked());
+  }
+
+  return object;
+}
+
+XmlFromObject::XmlFromObject() : attribute_prefix("@"), text_key("#text") {}
+
+// {attributePrefix, textKey}
+bool XmlFromObject::set_options(Local<Value> options) {
+  if (options->IsNullOrUndefined()) {
+    return true;
+  }
+  if (!options->IsObject()) {
+    Nan::ThrowTypeError("Bad argument: options must be an object");
+    return false;
+  }
+  Local<Object> opts = Nan::To<Object>(options).ToLocalChecked();
+
+  if (!readStringOption(opts, "attributePrefix", attribute_prefix) ||
+      !readStringOption(opts, "textKey", text_key)) {
+    return false;
+  }
+  // every key would name an attribute otherwise
+  if (attribute_prefix.empty()) {
+    Nan::ThrowTypeError("Bad argument: attributePrefix must not be empty");
+    return false;
+  }
+  return true;
+}
+
+bool XmlFromObject::append(xmlNode *parent, Local<Value> content) {
+  if (!content->IsObject() || content->IsArray()) {
+    Nan::ThrowTypeError("Bad argument: content must be an object");
+    return false;
+  }
+
+  xmlNode *last = parent->last;
+  if (add_content(parent, Nan::To<Object>(content).ToLocalChecked(),
+                  false)) {
+    return true;
+  }
+
+  xmlNode *added = (last != NULL) ? last->next : parent->children;
+  while (added != NULL) {
+    xmlNode *next = added->next;
+    xmlUnlinkNode(added);
+    xmlFreeNode(added);
+    added = next;
+  }
+  return false;
+}
+
+// give the element the namespace its prefix (or the default namespace)
+// is bound to
+static void resolveNamespace(xmlNode *element) {
+  const xmlChar *colon = xmlStrchr(element->name, ':');
+  xmlChar *prefix =
+      colon ? xmlStrndup(element->name, colon - element->name) : NULL;
+
+  xmlNs *ns = xmlSearchNs(element->doc, element, prefix);
+  if (ns != NULL) {
+    xmlSetNs(element, ns);
+    if (colon != NULL) {
+      xmlChar *local = xmlStrdup(colon + 1);
+      xmlNodeSetName(element, local);
+      xmlFree(local);
+    }
+  }
+  xmlFree(prefix);
+}
+
+bool XmlFromObject::add_content(xmlNode *parent, Local<Object> content,
+                                bool created) {
+  bool element = parent->type == XML_ELEMENT_NODE;
+  Local<Array> names = Nan::GetOwnPropertyNames(content).ToLocalChecked();
+
+  // namespace declarations first, the names of the element itself and
+  // of its attributes may use them
+  for (unsigned int i = 0; element && (i < names->Length()); i++) {
+    Local<Value> name = Nan::Get(names, i).ToLocalChecked();
+    Nan::Utf8String key(name);
+    std::string attr(*key);
+    if ((attr.compare(0, attribute_prefix.size(), attribute_prefix) != 0)) {
+      continue;
+    }
+    attr.erase(0, attribute_prefix.size());
+    if ((attr != "xmlns") && (attr.compare(0, 6, "xmlns:") != 0)) {
+      continue;
+    }
+
+    Local<Value> href = Nan::Get(content, name).ToLocalChecked();
+    xmlNewNs(parent, (const xmlChar *)*Nan::Utf8String(href),
+             (attr == "xmlns") ? NULL : (const xmlChar *)attr.c_str() + 6);
+  }
+  if (created) {
+    resolveNamespace(parent);
+  }
+
+  for (unsigned int i = 0; i < names->Length(); i++) {
+    Local<Value> name = Nan::Get(names, i).ToLocalChecked();
+    Local<Value> value = Nan::Get(content, name).ToLocalChecked();
+    Nan::Utf8String key(name);
+    std::string attr(*key);
+
+    if (attr.compare(0, attribute_prefix.size(), attribute_prefix) == 0) {
+      attr.erase(0, attribute_prefix.size());
+      if (!element) {
+        Nan::ThrowTypeError("Bad argument: a document cannot have attributes");
+        return false;
+      }
+      if ((attr == "xmlns") || (attr.compare(0, 6, "xmlns:") == 0) ||
+          value->IsNullOrUndefined()) {
+        continue;
+      }
+      xmlSetProp(parent, (const xmlChar *)attr.c_str(),
+                 (const xmlChar *)*Nan::Utf8String(value));
+    } else if (attr == text_key) {
+      if (!element) {
+        Nan::ThrowTypeError("Bad argument: a document cannot have text");
+        return false;
+      }
+      if (!value->IsNullOrUndefined()) {
+        xmlNodeAddContent(parent, (const xmlChar *)*Nan::Utf8String(value));
+      }
+    } else if (value->IsArray()) {
+      // one element per item
+      Local<Array> values = Local<Array>::Cast(value);
+      for (unsigned int j = 0; j < values->Length(); j++) {
+        if (!add_element(parent, name, Nan::Get(values, j).ToLocalChecked())) {
+          return false;
+        }
+      }
+    } else if (!add_element(parent, name, value)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool XmlFromObject::add_element(xmlNode *parent, Local<Value> name,
+                                Local<Value> value) {
+  if (value->IsArray()) {
+    Nan::ThrowTypeError("Bad argument: arrays cannot be nested");
+    return false;
+  }
+
+  xmlNode *element = xmlNewDocNode(parent->doc, NULL,
+                                   (const xmlChar *)*Nan::Utf8String(name),
+                                   NULL);
+  if (element == NULL) {
+    Nan::ThrowError("Could not create element");
+    return false;
+  }
+  xmlAddChild(parent, element);
+
+  if (value->IsObject()) {
+    return add_content(element, Nan::To<Object>(value).ToLocalChecked(),
+                       true);
+  }
+
+  resolveNamespace(element);
+  if (!value->IsNullOrUndefined()) {
+    xmlNodeAddContent(element, (const xmlChar *)*Nan::Utf8String(value));
+  }
+  return true;
+}
+
+// a typed array holding a copy of the values
+template <typename TypedArray, typename T>
+static Local<TypedArray> typedArray(const std::vector<T> &values) {
+  size_t bytes = values.size() * sizeof(T);
+  Local<ArrayBuffer> buffer = ArrayBuffer::New(Isolate::GetCurrent(), bytes);
+  Local<TypedArray> array = TypedArray::New(buffer, 0, values.size());
+  if (bytes > 0) {
+    Nan::TypedArrayContents<T> contents(array);
+    memcpy(*contents, values.data(), bytes);
+  }
+  return array;
+}
+
+Local<Object> flatTree(xmlNode *top) {
+  std::vector<int32_t> parent;
+  std::vector<int32_t> first_child;
+  std::vector<int32_t> next_sibling;
+  std::vector<uint8_t> node_type;
+  std::vector<int32_t> name_id;
+  std::vector<uint32_t> text_offset;
+  std::string text;
+
+  std::unordered_map<std::string, int32_t> name_ids;
+  Local<Array> names = Nan::New<Array>();
+
+  // index of the open elements and of the last child added to each
+  std::vector<int32_t> ancestors(1, -1);
+  std::vector<int32_t> last_child(1, -1);
+
+  xmlNode *node = top->children;
+  while (node != NULL) {
+    bool named = false;
+    bool has_text = false;
+    switch (node->type) {
+    case XML_ELEMENT_NODE:
+    case XML_ENTITY_REF_NODE:
+      named = true;
+      break;
+    case XML_PI_NODE:
+      named = true;
+      has_text = true;
+      break;
+    case XML_TEXT_NODE:
+    case XML_CDATA_SECTION_NODE:
+    case XML_COMMENT_NODE:
+      has_text = true;
+      break;
+    default:
+      // dtds, xinclude markers and the like are left out
+      break;
+    }
+
+    if (named || has_text) {
+      int32_t index = static_cast<int32_t>(parent.size());
+      parent.push_back(ancestors.back());
+      first_child.push_back(-1);
+      next_sibling.push_back(-1);
+      node_type.push_back(static_cast<uint8_t>(node->type));
+      text_offset.push_back(static_cast<uint32_t>(text.size()));
+
+      if (last_child.back() != -1) {
+        next_sibling[last_child.back()] = index;
+      } else if (ancestors.back() != -1) {
+        first_child[ancestors.back()] = index;
+      }
+      last_child.back() = index;
+
+      int32_t id = -1;
+      if (named) {
+        std::string name;
+        if ((node->type == XML_ELEMENT_NODE) && (node->ns != NULL) &&
+            (node->ns->prefix != NULL)) {
+          name = (const char *)node->ns->prefix;
+          name += ':';
+        }
+        name += (const char *)node->name;
+
+        std::unordered_map<std::string, int32_t>::iterator found =
+            name_ids.find(name);
+        if (found == name_ids.end()) {
+          id = static_cast<int32_t>(name_ids.size());
+          name_ids[name] = id;
+          Nan::Set(names, id, Nan::New<String>(name).ToLocalChecked());
+        } else {
+          id = found->second;
+        }
+      }
+      name_id.push_back(id);
+
+      if (has_text && (node->content != NULL)) {
+        text += (const char *)node->content;
+      }
+
+      if ((node->type == XML_ELEMENT_NODE) && (node->children != NULL)) {
+        ancestors.push_back(index);
+        last_child.push_back(-1);
+        node = node->children;
+        continue;
+      }
+    }
+
+    while ((node->next == NULL) && (node->parent != top)) {
+      node = node->parent;
+      ancestors.pop_back();
+      last_child.pop_back();
+    }
+    node = node->next;
+  }
+  text_offset.push_back(static_cast<uint32_t>(text.size()));
+
+  Local<Object> tree = Nan::New<Object>();
+  Nan::Set(tree, Nan::New<String>("length").ToLocalChecked(),
+           Nan::New<Number>(static_cast<double>(parent.size())));
+  Nan::Set(tree, Nan::New<String>("parent").ToLocalChecked(),
+           typedArray<Int32Array>(parent));
+  Nan::Set(tree, Nan::New<String>("firstChild").ToLocalChecked(),
+           typedArray<Int32Array>(first_child));
+  Nan::Set(tree, Nan::New<String>("nextSibling").ToLocalChecked(),
+           typedArray<Int32Array>(next_sibling));
+  Nan::Set(tree, Nan::New<String>("nodeType").ToLocalChecked(),
+           typedArray<Uint8Array>(node_type));
+  Nan::Set(tree, Nan::New<String>("nameId").ToLocalChecked(),
+           typedArray<Int32Array>(name_id));
+  Nan::Set(tree, Nan::New<String>("names").ToLocalChecked(), names);
+  Nan::Set(tree, Nan::New<String>("textOffset").ToLocalChecked(),
+           typedArray<Uint32Array>(text_offset));
+  Nan::Set(tree, Nan::New<String>("text").ToLocalChecked(),
+           Nan::CopyBuffer(text.data(), static_cast<uint32_t>(text.size()))
+               .ToLocalChecked());
+  return tree;
+}
+
+} // namespace libxmljs
@@ -0,0 +1,89 @@
+// Copyright 2009, Squish Tech, LLC.
+#ifndef SRC_XML_JS_OBJECT_H_
+#define SRC_XML_JS_OBJECT_H_
+
+#include <libxml/tree.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "libxmljs.h"
+
+namespace libxmljs {
+
+// converts a subtree to plain js objects in one pass, see toObject()
+class XmlToObject {
+public:
+  XmlToObject();
+
+  // read the options of toObject(), returns false (with an exception
+  // pending) for invalid ones
+  bool set_options(v8::Local<v8::Value> options);
+
+  // an object for elements with attributes or child elements, the text
+  // content for any other element. Must be called within a handle scope.
+  v8::Local<v8::Value> convert(xmlNode *element);
+
+protected:
+  // how namespaced names are turned into keys
+  enum NamespaceMode {
+    // "prefix:name"
+    NS_PREFIX,
+    // "name"
+    NS_LOCAL,
+    // "{uri}name"
+    NS_URI
+  };
+
+  v8::Local<v8::String> key(xmlNs *ns, const xmlChar *name, bool attribute);
+  bool always_array(const xmlChar *name);
+
+  std::string attribute_prefix;
+  std::string text_key;
+  NamespaceMode namespaces;
+
+  // alwaysArray: true, or the names listed
+  bool all_arrays;
+  std::set<std::string> array_names;
+
+  // keys created so far, by namespace, name and whether an attribute
+  std::map<std::pair<std::pair<xmlNs *, const xmlChar *>, bool>,
+           v8::Local<v8::String>>
+      keys;
+};
+
+// builds a subtree from plain js objects of the shape toObject()
+// returns, see appendObject()
+class XmlFromObject {
+public:
+  XmlFromObject();
+
+  // read the options of appendObject(), returns false (with an
+  // exception pending) for invalid ones
+  bool set_options(v8::Local<v8::Value> options);
+
+  // add the content described by the {name: value} object to `parent`,
+  // an element or document node. Returns false (with an exception
+  // pending) on failure, the nodes added so far are removed again.
+  bool append(xmlNode *parent, v8::Local<v8::Value> content);
+
+protected:
+  // `created` is set for elements made from the content itself
+  bool add_content(xmlNode *parent, v8::Local<v8::Object> content,
+                   bool created);
+  bool add_element(xmlNode *parent, v8::Local<v8::Value> name,
+                   v8::Local<v8::Value> value);
+
+  std::string attribute_prefix;
+  std::string text_key;
+};
+
+// the nodes below `top` in document order as typed arrays, see
+// Document#toFlatTree()
+v8::Local<v8::Object> flatTree(xmlNode *top);
+
+} // namespace libxmljs
+
+#endif // SRC_XML_JS_OBJECT_H_
@@ -27,6 +27,8 @@ NAN_METHOD(XmlNamespace::New) {
 
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(
       Nan::To<Object>(info[0]).ToLocalChecked());
+  NODE_DISPOSED_CHECK(node)
+  DOCUMENT_MUTATION_CHECK(node->xml_obj->doc)
 
   Nan::Utf8String *prefix = 0;
   Nan::Utf8String *href = 0;
@@ -42,20 +44,21 @@ NAN_METHOD(XmlNamespace::New) {
 
   delete prefix;
   delete href;
+  XmlDocument::TreeChanged(node->xml_obj->doc);
 
-  XmlNamespace *namesp = new XmlNamespace(ns);
+  XmlNamespace *namesp = new XmlNamespace(ns, node);
   namesp->Wrap(info.This());
 
   return info.GetReturnValue().Set(info.This());
 }
 
-Local<Object> XmlNamespace::New(xmlNs *node) {
+Local<Object> XmlNamespace::New(xmlNs *node, XmlNode *owner) {
   Nan::EscapableHandleScope scope;
   if (node->_private) {
     return scope.Escape(static_cast<XmlNamespace *>(node->_private)->handle());
   }
 
-  XmlNamespace *ns = new XmlNamespace(node);
+  XmlNamespace *ns = new XmlNamespace(node, owner);
   Local<Object> obj =
       Nan::NewInstance(
           Nan::GetFunction(Nan::New(constructor_template)).ToLocalChecked())
@@ -64,8 +67,10 @@ Local<Object> XmlNamespace::New(xmlNs *node) {
   return scope.Escape(obj);
 }
 
-XmlNamespace::XmlNamespace(xmlNs *node) : xml_obj(node) {
+XmlNamespace::XmlNamespace(xmlNs *ns, XmlNode *node)
+    : xml_obj(ns), node(node) {
   xml_obj->_private = this;
+  this->node->Ref();
 
   /*
    * If a context is present and wrapped, increment its refcount to ensure
@@ -73,12 +78,11 @@ XmlNamespace::XmlNamespace(xmlNs *node) : xml_obj(node) {
    * namespace is accessible.
    */
   if ((xml_obj->context) && (xml_obj->context->_private != NULL)) {
-    this->context = xml_obj->context;
     // a namespace must be created on a given node
-    XmlDocument *doc = static_cast<XmlDocument *>(xml_obj->context->_private);
-    doc->Ref();
+    this->document = static_cast<XmlDocument *>(xml_obj->context->_private);
+    this->document->Ref();
   } else {
-    this->context = NULL;
+    this->document = NULL;
   }
 }
 
@@ -92,18 +96,18 @@ XmlNamespace::~XmlNamespace() {
   }
 
   /*
-   * The context pointer is only set if this wrapper has incremented the
-   * refcount of the context wrapper.
+   * The document pointer is only set if this wrapper has incremented the
+   * refcount of the context wrapper. The wrapper outlives its xmlDoc when
+   * the document was disposed, so it is not looked up through the xmlDoc.
    */
-  if (this->context != NULL) {
-    if (this->context->_private != NULL) {
-      // release the hold and allow the document to be freed
-      XmlDocument *doc = static_cast<XmlDocument *>(this->context->_private);
-      doc->Unref();
-    }
-    this->context = NULL;
+  if (this->document != NULL) {
+    // release the hold and allow the document to be freed
+    this->document->Unref();
+    this->document = NULL;
   }
 
+  this->node->Unref();
+
   // We do not free the xmlNode here. It could still be part of a document
   // It will be freed when the doc is freed
 }
@@ -112,6 +116,9 @@ NAN_METHOD(XmlNamespace::Href) {
   Nan::HandleScope scope;
   XmlNamespace *ns = Nan::ObjectWrap::Unwrap<XmlNamespace>(info.This());
   assert(ns);
+  if (ns->xml_obj == NULL) {
+    return Nan::ThrowError("Namespace has been freed");
+  }
   return info.GetReturnValue().Set(ns->get_href());
 }
 
@@ -119,6 +126,9 @@ NAN_METHOD(XmlNamespace::Prefix) {
   Nan::HandleScope scope;
   XmlNamespace *ns = Nan::ObjectWrap::Unwrap<XmlNamespace>(info.This());
   assert(ns);
+  if (ns->xml_obj == NULL) {
+    return Nan::ThrowError("Namespace has been freed");
+  }
   return info.GetReturnValue().Set(ns->get_prefix());
 }
 
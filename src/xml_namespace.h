@@ -9,20 +9,28 @@
 
 namespace libxmljs {
 
+class XmlDocument;
+class XmlNode;
+
 class XmlNamespace : public Nan::ObjectWrap {
 public:
   xmlNs *xml_obj;
 
-  xmlDoc *context; // reference-managed context
+  // the wrapper of the namespace context, ref'd while this is alive
+  XmlDocument *document;
+
+  // the wrapper of the node the namespace was found through, ref'd while
+  // this is alive so that the tree holding the namespace isn't freed
+  XmlNode *node;
 
   static void Initialize(v8::Local<v8::Object> target);
   static Nan::Persistent<v8::FunctionTemplate> constructor_template;
 
-  explicit XmlNamespace(xmlNs *ns);
+  XmlNamespace(xmlNs *ns, XmlNode *node);
   XmlNamespace(xmlNs *node, const char *prefix, const char *href);
   ~XmlNamespace();
 
-  static v8::Local<v8::Object> New(xmlNs *ns);
+  static v8::Local<v8::Object> New(xmlNs *ns, XmlNode *node);
 
 protected:
   static NAN_METHOD(New);
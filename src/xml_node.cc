@@ -23,6 +23,7 @@ NAN_METHOD(XmlNode::Doc) {
   Nan::HandleScope scope;
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(info.This());
   assert(node);
+  NODE_DISPOSED_CHECK(node)
 
   return info.GetReturnValue().Set(node->get_doc());
 }
@@ -31,12 +32,15 @@ NAN_METHOD(XmlNode::Namespace) {
   Nan::HandleScope scope;
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(info.This());
   assert(node);
+  NODE_DISPOSED_CHECK(node)
 
   // #namespace() Get the node's namespace
   if (info.Length() == 0) {
     return info.GetReturnValue().Set(node->get_namespace());
   }
 
+  DOCUMENT_MUTATION_CHECK(node->xml_obj->doc)
+
   if (info[0]->IsNull())
     return info.GetReturnValue().Set(node->remove_namespace());
 
@@ -55,7 +59,7 @@ NAN_METHOD(XmlNode::Namespace) {
     xmlNs *found_ns = node->find_namespace(*ns_to_find);
     if (found_ns) {
       // maybe build
-      Local<Object> existing = XmlNamespace::New(found_ns);
+      Local<Object> existing = XmlNamespace::New(found_ns, node);
       ns = Nan::ObjectWrap::Unwrap<XmlNamespace>(existing);
     }
   }
@@ -95,6 +99,7 @@ NAN_METHOD(XmlNode::Namespaces) {
   Nan::HandleScope scope;
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(info.This());
   assert(node);
+  NODE_DISPOSED_CHECK(node)
 
   // ignore everything but a literal true; different from IsFalse
   if ((info.Length() == 0) || !info[0]->IsTrue()) {
@@ -108,6 +113,7 @@ NAN_METHOD(XmlNode::Parent) {
   Nan::HandleScope scope;
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(info.This());
   assert(node);
+  NODE_DISPOSED_CHECK(node)
 
   return info.GetReturnValue().Set(node->get_parent());
 }
@@ -116,6 +122,7 @@ NAN_METHOD(XmlNode::PrevSibling) {
   Nan::HandleScope scope;
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(info.This());
   assert(node);
+  NODE_DISPOSED_CHECK(node)
 
   return info.GetReturnValue().Set(node->get_prev_sibling());
 }
@@ -124,6 +131,7 @@ NAN_METHOD(XmlNode::NextSibling) {
   Nan::HandleScope scope;
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(info.This());
   assert(node);
+  NODE_DISPOSED_CHECK(node)
 
   return info.GetReturnValue().Set(node->get_next_sibling());
 }
@@ -132,6 +140,7 @@ NAN_METHOD(XmlNode::LineNumber) {
   Nan::HandleScope scope;
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(info.This());
   assert(node);
+  NODE_DISPOSED_CHECK(node)
 
   return info.GetReturnValue().Set(node->get_line_number());
 }
@@ -140,6 +149,7 @@ NAN_METHOD(XmlNode::Type) {
   Nan::HandleScope scope;
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(info.This());
   assert(node);
+  NODE_DISPOSED_CHECK(node)
 
   return info.GetReturnValue().Set(node->get_type());
 }
@@ -148,6 +158,7 @@ NAN_METHOD(XmlNode::ToString) {
   Nan::HandleScope scope;
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(info.This());
   assert(node);
+  NODE_DISPOSED_CHECK(node)
 
   int options = 0;
 
@@ -223,6 +234,8 @@ NAN_METHOD(XmlNode::Remove) {
   Nan::HandleScope scope;
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(info.This());
   assert(node);
+  NODE_DISPOSED_CHECK(node)
+  DOCUMENT_MUTATION_CHECK(node->xml_obj->doc)
 
   node->remove();
 
@@ -233,6 +246,7 @@ NAN_METHOD(XmlNode::Clone) {
   Nan::HandleScope scope;
   XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(info.This());
   assert(node);
+  NODE_DISPOSED_CHECK(node)
 
   bool recurse = true;
 
@@ -263,252 +277,196 @@ Local<Value> XmlNode::New(xmlNode *node) {
   }
 }
 
-XmlNode::XmlNode(xmlNode *node) : xml_obj(node) {
-  xml_obj->_private = this;
-  this->ancestor = NULL;
-
-  if ((xml_obj->doc != NULL) && (xml_obj->doc->_private != NULL)) {
-    this->doc = xml_obj->doc;
-    static_cast<XmlDocument *>(this->doc->_private)->Ref();
-  }
-
-  this->ref_wrapped_ancestor();
+static bool is_document(xmlNode *node) {
+  return (node->type == XML_DOCUMENT_NODE) ||
+#ifdef LIBXML_DOCB_ENABLED
+         (node->type == XML_DOCB_DOCUMENT_NODE) ||
+#endif
+         (node->type == XML_HTML_DOCUMENT_NODE);
 }
 
 /*
- * Return the (non-document) root, or a wrapped ancestor: whichever is closest
+ * The wrapper of the root of the tree the node is in, NULL if the tree
+ * is attached to a document, which keeps it alive, or the root isn't
+ * wrapped.
  */
-xmlNode *get_wrapped_ancestor_or_root(xmlNode *xml_obj) {
-  while ((xml_obj->parent != NULL) &&
-         (static_cast<void *>(xml_obj->doc) !=
-          static_cast<void *>(xml_obj->parent)) &&
-         (xml_obj->parent->_private == NULL)) {
-    xml_obj = xml_obj->parent;
+static XmlNode *root_wrapper(xmlNode *node) {
+  while (node->parent != NULL) {
+    node = node->parent;
   }
-  return ((xml_obj->parent != NULL) && (static_cast<void *>(xml_obj->doc) !=
-                                        static_cast<void *>(xml_obj->parent)))
-             ? xml_obj->parent
-             : xml_obj;
+  return is_document(node) ? NULL : static_cast<XmlNode *>(node->_private);
 }
 
-/*
- * Search linked list for javascript wrapper, ignoring given node.
- */
-xmlAttr *get_wrapped_attr_in_list(xmlAttr *xml_obj, void *skip_xml_obj) {
-  xmlAttr *wrapped_attr = NULL;
-  while (xml_obj != NULL) {
-    if ((xml_obj != skip_xml_obj) && (xml_obj->_private != NULL)) {
-      wrapped_attr = xml_obj;
-      xml_obj = NULL;
-    } else {
-      xml_obj = xml_obj->next;
+static size_t wrapped_list(xmlNode *node) {
+  size_t count = 0;
+  for (; node != NULL; node = node->next) {
+    if (node->_private != NULL) {
+      count++;
     }
   }
-  return wrapped_attr;
+  return count;
 }
 
-xmlNs *get_wrapped_ns_in_list(xmlNs *xml_obj, void *skip_xml_obj) {
-  xmlNs *wrapped_ns = NULL;
-  while (xml_obj != NULL) {
-    if ((xml_obj != skip_xml_obj) && (xml_obj->_private != NULL)) {
-      wrapped_ns = xml_obj;
-      xml_obj = NULL;
-    } else {
-      xml_obj = xml_obj->next;
+/*
+ * The wrapped nodes in the subtree of the node, itself included. Visits
+ * what xmlFreeNode frees, without recursing: trees may be deep.
+ */
+size_t XmlNode::wrapped_subtree(xmlNode *top) {
+  size_t count = 0;
+  xmlNode *node = top;
+  for (;;) {
+    if (node->_private != NULL) {
+      count++;
+    }
+    if ((node->type == XML_ELEMENT_NODE) ||
+        (node->type == XML_XINCLUDE_START) ||
+        (node->type == XML_XINCLUDE_END)) {
+      for (xmlAttr *attr = node->properties; attr != NULL; attr = attr->next) {
+        count += (attr->_private != NULL) ? 1 : 0;
+        count += wrapped_list(attr->children);
+      }
+    }
+    if ((node->type != XML_ENTITY_REF_NODE) && (node->children != NULL)) {
+      node = node->children;
+      continue;
     }
+    while ((node != top) && (node->next == NULL)) {
+      node = node->parent;
+    }
+    if (node == top) {
+      return count;
+    }
+    node = node->next;
   }
-  return wrapped_ns;
 }
 
-xmlNode *get_wrapped_node_in_children(xmlNode *xml_obj, xmlNode *skip_xml_obj);
-
-/*
- * Search document for javascript wrapper, ignoring given node.
- * Based on xmlFreeDoc.
- */
-xmlNode *get_wrapped_node_in_document(xmlDoc *xml_obj, xmlNode *skip_xml_obj) {
-  xmlNode *wrapped_node = NULL;
-  if ((xml_obj->extSubset != NULL) && (xml_obj->extSubset->_private != NULL) &&
-      (static_cast<void *>(xml_obj->extSubset) != skip_xml_obj)) {
-    wrapped_node = reinterpret_cast<xmlNode *>(xml_obj->extSubset);
+void XmlNode::add_tree_wrappers(size_t count) {
+  if (count == 0) {
+    return;
   }
-  if ((wrapped_node == NULL) && (xml_obj->intSubset != NULL) &&
-      (xml_obj->intSubset->_private != NULL) &&
-      (static_cast<void *>(xml_obj->intSubset) != skip_xml_obj)) {
-    wrapped_node = reinterpret_cast<xmlNode *>(xml_obj->intSubset);
+  if (tree_wrappers == 0) {
+    this->Ref();
   }
-  if ((wrapped_node == NULL) && (xml_obj->children != NULL)) {
-    wrapped_node =
-        get_wrapped_node_in_children(xml_obj->children, skip_xml_obj);
+  tree_wrappers += count;
+}
+
+void XmlNode::remove_tree_wrappers(size_t count) {
+  if ((count == 0) || (tree_wrappers == 0)) {
+    return;
   }
-  if ((wrapped_node == NULL) && (xml_obj->oldNs != NULL)) {
-    wrapped_node = reinterpret_cast<xmlNode *>(
-        get_wrapped_ns_in_list(xml_obj->oldNs, skip_xml_obj));
+  tree_wrappers -= (count < tree_wrappers) ? count : tree_wrappers;
+  if (tree_wrappers == 0) {
+    this->Unref();
   }
-  return wrapped_node;
 }
 
 /*
- * Search children of node for javascript wrapper, ignoring given node.
- * Based on xmlFreeNodeList.
+ * The node takes the wrappers of its subtree along to a tree of its
+ * own. This has to look at the whole subtree, but only once per unlink
+ * rather than on every finalization.
  */
-xmlNode *get_wrapped_node_in_children(xmlNode *xml_obj, xmlNode *skip_xml_obj) {
-
-  xmlNode *wrapped_node = NULL;
-
-  if (xml_obj->type == XML_NAMESPACE_DECL) {
-    return reinterpret_cast<xmlNode *>(get_wrapped_ns_in_list(
-        reinterpret_cast<xmlNs *>(xml_obj), skip_xml_obj));
+void XmlNode::unlink_wrapped(xmlNode *node) {
+  if (node->parent == NULL) {
+    return;
   }
-
-  if ((xml_obj->type == XML_DOCUMENT_NODE) ||
-#ifdef LIBXML_DOCB_ENABLED
-      (xml_obj->type == XML_DOCB_DOCUMENT_NODE) ||
-#endif
-      (xml_obj->type == XML_HTML_DOCUMENT_NODE)) {
-    return get_wrapped_node_in_document(reinterpret_cast<xmlDoc *>(xml_obj),
-                                        skip_xml_obj);
+  size_t count = wrapped_subtree(node);
+  if (count == 0) {
+    return;
   }
-
-  xmlNode *next;
-  while (xml_obj != NULL) {
-    next = xml_obj->next;
-
-    if ((xml_obj != skip_xml_obj) && (xml_obj->_private != NULL)) {
-      wrapped_node = xml_obj;
-    } else {
-
-      if ((xml_obj->children != NULL) &&
-          (xml_obj->type != XML_ENTITY_REF_NODE)) {
-        wrapped_node =
-            get_wrapped_node_in_children(xml_obj->children, skip_xml_obj);
-      }
-
-      if ((wrapped_node == NULL) && ((xml_obj->type == XML_ELEMENT_NODE) ||
-                                     (xml_obj->type == XML_XINCLUDE_START) ||
-                                     (xml_obj->type == XML_XINCLUDE_END))) {
-
-        if ((wrapped_node == NULL) && (xml_obj->properties != NULL)) {
-          wrapped_node = reinterpret_cast<xmlNode *>(
-              get_wrapped_attr_in_list(xml_obj->properties, skip_xml_obj));
-        }
-
-        if ((wrapped_node == NULL) && (xml_obj->nsDef != NULL)) {
-          wrapped_node = reinterpret_cast<xmlNode *>(
-              get_wrapped_ns_in_list(xml_obj->nsDef, skip_xml_obj));
-        }
-      }
-    }
-
-    if (wrapped_node != NULL) {
-      break;
-    }
-
-    xml_obj = next;
+  XmlNode *root = root_wrapper(node);
+  if (root != NULL) {
+    root->remove_tree_wrappers(count);
   }
+  if (node->_private != NULL) {
+    static_cast<XmlNode *>(node->_private)->add_tree_wrappers(count - 1);
+  }
+}
 
-  return wrapped_node;
+void XmlNode::link_wrapped(xmlNode *node) {
+  if ((node->parent == NULL) || (node->_private == NULL)) {
+    return;
+  }
+  XmlNode *wrapper = static_cast<XmlNode *>(node->_private);
+  XmlNode *root = root_wrapper(node);
+  if (root != NULL) {
+    root->add_tree_wrappers(wrapper->tree_wrappers + 1);
+  }
+  wrapper->remove_tree_wrappers(wrapper->tree_wrappers);
 }
 
 /*
- * Search descendants of node to find javascript wrapper,
- * optionally ignoring given node. Based on xmlFreeNode.
+ * The descendants are freed first, each taking itself off the count of
+ * the root.
  */
-xmlNode *get_wrapped_descendant(xmlNode *xml_obj,
-                                xmlNode *skip_xml_obj = NULL) {
+void XmlNode::free_wrapped(xmlNode *node) {
+  XmlNode *wrapper = static_cast<XmlNode *>(node->_private);
+  wrapper->remove_tree_wrappers(wrapper->tree_wrappers);
+  XmlNode *root = root_wrapper(node);
+  if ((root != NULL) && (root != wrapper)) {
+    root->remove_tree_wrappers(1);
+  }
+}
 
-  xmlNode *wrapped_descendant = NULL;
+XmlNode::XmlNode(xmlNode *node)
+    : xml_obj(node), document(NULL), prev_wrapper(NULL), next_wrapper(NULL),
+      tree_wrappers(0) {
+  xml_obj->_private = this;
 
-  if (xml_obj->type == XML_DTD_NODE) {
-    return (xml_obj->children == NULL)
-               ? NULL
-               : get_wrapped_node_in_children(xml_obj->children, skip_xml_obj);
+  if ((xml_obj->doc != NULL) && (xml_obj->doc->_private != NULL)) {
+    this->document = static_cast<XmlDocument *>(xml_obj->doc->_private);
+    this->document->Ref();
+    this->document->add_wrapper(this);
   }
 
-  if (xml_obj->type == XML_NAMESPACE_DECL) {
-    return NULL;
+  if (xml_obj->parent == NULL) {
+    return;
   }
 
-  if (xml_obj->type == XML_ATTRIBUTE_NODE) {
-    return (xml_obj->children == NULL)
-               ? NULL
-               : get_wrapped_node_in_children(xml_obj->children, skip_xml_obj);
+  // the root of a detached tree is wrapped while anything in the tree
+  // is, a tree built without wrappers gets its root wrapped here
+  xmlNode *root = xml_obj->parent;
+  while (root->parent != NULL) {
+    root = root->parent;
   }
-
-  if ((xml_obj->children != NULL) && (xml_obj->type != XML_ENTITY_REF_NODE)) {
-    wrapped_descendant =
-        get_wrapped_node_in_children(xml_obj->children, skip_xml_obj);
+  if (is_document(root)) {
+    return;
   }
-
-  if ((xml_obj->type == XML_ELEMENT_NODE) ||
-      (xml_obj->type == XML_XINCLUDE_START) ||
-      (xml_obj->type == XML_XINCLUDE_END)) {
-
-    if ((wrapped_descendant == NULL) && (xml_obj->properties != NULL)) {
-      wrapped_descendant = reinterpret_cast<xmlNode *>(
-          get_wrapped_attr_in_list(xml_obj->properties, skip_xml_obj));
-    }
-
-    if ((wrapped_descendant == NULL) && (xml_obj->nsDef != NULL)) {
-      wrapped_descendant = reinterpret_cast<xmlNode *>(
-          get_wrapped_ns_in_list(xml_obj->nsDef, skip_xml_obj));
-    }
+  if (root->_private != NULL) {
+    static_cast<XmlNode *>(root->_private)->add_tree_wrappers(1);
+    return;
   }
-
-  return wrapped_descendant;
+  Nan::HandleScope scope;
+  XmlNode::New(root);
+  static_cast<XmlNode *>(root->_private)
+      ->add_tree_wrappers(wrapped_subtree(root) - 1);
 }
 
+/*
+ * A detached tree is freed along with the wrapper of its root, which
+ * holds a reference to itself while any other node of the tree is
+ * wrapped.
+ */
 XmlNode::~XmlNode() {
-  if ((this->doc != NULL) && (this->doc->_private != NULL)) {
-    static_cast<XmlDocument *>(this->doc->_private)->Unref();
+  // not through xml_obj->doc, which is gone once the document was disposed
+  if (this->document != NULL) {
+    this->document->remove_wrapper(this);
+    this->document->Unref();
   }
-  this->unref_wrapped_ancestor();
   if (xml_obj == NULL)
     return;
 
   xml_obj->_private = NULL;
   if (xml_obj->parent == NULL) {
-    if (get_wrapped_descendant(xml_obj) == NULL) {
-      xmlFreeNode(xml_obj);
-    }
-  } else {
-    xmlNode *ancestor = get_wrapped_ancestor_or_root(xml_obj);
-    if ((ancestor->_private == NULL) && (ancestor->parent == NULL) &&
-        (get_wrapped_descendant(ancestor, xml_obj) == NULL)) {
-      xmlFreeNode(ancestor);
-    }
-  }
-}
-
-xmlNode *XmlNode::get_wrapped_ancestor() {
-  xmlNode *ancestor = get_wrapped_ancestor_or_root(xml_obj);
-  return ((xml_obj == ancestor) || (ancestor->_private == NULL)) ? NULL
-                                                                 : ancestor;
-}
-
-void XmlNode::ref_wrapped_ancestor() {
-  xmlNode *ancestor = this->get_wrapped_ancestor();
-
-  // if our closest wrapped ancestor has changed then we either
-  // got removed, added, or a closer ancestor was wrapped
-  if (ancestor != this->ancestor) {
-    this->unref_wrapped_ancestor();
-    this->ancestor = ancestor;
+    xmlFreeNode(xml_obj);
+    return;
   }
 
-  if (this->ancestor != NULL) {
-    XmlNode *node = static_cast<XmlNode *>(this->ancestor->_private);
-    node->Ref();
+  XmlNode *root = root_wrapper(xml_obj);
+  if (root != NULL) {
+    root->remove_tree_wrappers(1);
   }
 }
 
-void XmlNode::unref_wrapped_ancestor() {
-  if ((this->ancestor != NULL) && (this->ancestor->_private != NULL)) {
-    (static_cast<XmlNode *>(this->ancestor->_private))->Unref();
-  }
-  this->ancestor = NULL;
-}
-
 Local<Value> XmlNode::get_doc() {
   Nan::EscapableHandleScope scope;
   return scope.Escape(XmlDocument::New(xml_obj->doc));
@@ -516,6 +474,10 @@ Local<Value> XmlNode::get_doc() {
 
 Local<Value> XmlNode::remove_namespace() {
   xml_obj->ns = NULL;
+  XmlDocument::TreeChanged(xml_obj->doc);
+  if (xml_obj->type == XML_ATTRIBUTE_NODE) {
+    XmlDocument::AttributesChanged(xml_obj->parent);
+  }
   return Nan::Null();
 }
 
@@ -525,12 +487,16 @@ Local<Value> XmlNode::get_namespace() {
     return scope.Escape(Nan::Null());
   }
 
-  return scope.Escape(XmlNamespace::New(xml_obj->ns));
+  return scope.Escape(XmlNamespace::New(xml_obj->ns, this));
 }
 
 void XmlNode::set_namespace(xmlNs *ns) {
   xmlSetNs(xml_obj, ns);
   assert(xml_obj->ns);
+  XmlDocument::TreeChanged(xml_obj->doc);
+  if (xml_obj->type == XML_ATTRIBUTE_NODE) {
+    XmlDocument::AttributesChanged(xml_obj->parent);
+  }
 }
 
 xmlNs *XmlNode::find_namespace(const char *search_str) {
@@ -555,7 +521,7 @@ Local<Value> XmlNode::get_all_namespaces() {
   if (nsList != NULL) {
     for (int i = 0; nsList[i] != NULL; i++) {
       Local<Number> index = Nan::New<Number>(i);
-      Local<Object> ns = XmlNamespace::New(nsList[i]);
+      Local<Object> ns = XmlNamespace::New(nsList[i], this);
       Nan::Set(namespaces, index, ns);
     }
     xmlFree(nsList);
@@ -572,7 +538,7 @@ Local<Value> XmlNode::get_local_namespaces() {
   xmlNs *nsDef = xml_obj->nsDef;
   for (int i = 0; nsDef; i++, nsDef = nsDef->next) {
     Local<Number> index = Nan::New<Number>(i);
-    Local<Object> ns = XmlNamespace::New(nsDef);
+    Local<Object> ns = XmlNamespace::New(nsDef, this);
     Nan::Set(namespaces, index, ns);
   }
 
@@ -649,18 +615,56 @@ Local<Value> XmlNode::to_string(int options) {
 }
 
 void XmlNode::remove() {
-  this->unref_wrapped_ancestor();
+  xmlNode *parent = xml_obj->parent;
+  unlink_wrapped(xml_obj);
   xmlUnlinkNode(xml_obj);
+  XmlDocument::TreeChanged(xml_obj->doc);
+  if ((xml_obj->type == XML_ATTRIBUTE_NODE) && (parent != NULL)) {
+    XmlDocument::AttributesChanged(parent);
+  }
 }
 
-void XmlNode::add_child(xmlNode *child) { xmlAddChild(xml_obj, child); }
+// text nodes may be merged into a neighbour and freed instead of added
+
+void XmlNode::add_child(xmlNode *child) {
+  if (xmlAddChild(xml_obj, child) == child) {
+    link_wrapped(child);
+    XmlDocument::NodeLinked(child);
+  }
+  XmlDocument::TreeChanged(xml_obj->doc);
+}
 
 void XmlNode::add_prev_sibling(xmlNode *node) {
-  xmlAddPrevSibling(xml_obj, node);
+  if (xmlAddPrevSibling(xml_obj, node) == node) {
+    link_wrapped(node);
+    XmlDocument::NodeLinked(node);
+  }
+  XmlDocument::TreeChanged(xml_obj->doc);
 }
 
 void XmlNode::add_next_sibling(xmlNode *node) {
-  xmlAddNextSibling(xml_obj, node);
+  if (xmlAddNextSibling(xml_obj, node) == node) {
+    link_wrapped(node);
+    XmlDocument::NodeLinked(node);
+  }
+  XmlDocument::TreeChanged(xml_obj->doc);
+}
+
+void XmlNode::replace_node(xmlNode *node) {
+  if (node == xml_obj) {
+    return;
+  }
+  unlink_wrapped(xml_obj);
+  unlink_wrapped(node);
+  xmlReplaceNode(xml_obj, node);
+
+  // nothing moved if the node can't take the place of this one
+  if (xml_obj->parent != NULL) {
+    link_wrapped(xml_obj);
+  }
+  link_wrapped(node);
+  XmlDocument::TreeChanged(xml_obj->doc);
+  XmlDocument::NodeLinked(node);
 }
 
 xmlNode *XmlNode::import_node(xmlNode *node) {
@@ -674,9 +678,11 @@ xmlNode *XmlNode::import_node(xmlNode *node) {
   }
 }
 
-Local<Value> XmlNode::get_type() {
+Local<Value> XmlNode::get_type() { return type_name(xml_obj->type); }
+
+Local<Value> XmlNode::type_name(xmlElementType type) {
   Nan::EscapableHandleScope scope;
-  switch (xml_obj->type) {
+  switch (type) {
   case XML_ELEMENT_NODE:
     return scope.Escape(Nan::New<String>("element").ToLocalChecked());
   case XML_ATTRIBUTE_NODE:
@@ -7,21 +7,28 @@
 
 namespace libxmljs {
 
+class XmlDocument;
+
 class XmlNode : public Nan::ObjectWrap {
 public:
   xmlNode *xml_obj;
 
-  // reference to a parent XmlNode or XmlElement
-  xmlNode *ancestor;
+  // publicly expose ref functions, namespace wrappers hold on to nodes
+  using Nan::ObjectWrap::Ref;
+  using Nan::ObjectWrap::Unref;
 
-  // referencing functions
-  void ref_wrapped_ancestor();
-  void unref_wrapped_ancestor();
-  xmlNode *get_wrapped_ancestor();
   int refs() { return refs_; };
 
-  // the doc ref'd by this proxy
-  xmlDoc *doc;
+  // the document wrapper ref'd by this proxy
+  XmlDocument *document;
+
+  // the other node wrappers of the document, see XmlDocument::dispose()
+  XmlNode *prev_wrapper;
+  XmlNode *next_wrapper;
+
+  // the number of other wrapped nodes in the tree this is the detached
+  // root of, a reference to itself is held while there are any
+  size_t tree_wrappers;
 
   explicit XmlNode(xmlNode *node);
   virtual ~XmlNode();
@@ -32,7 +39,24 @@ public:
   // create new XmlElement, XmlAttribute, etc. to wrap a libxml xmlNode
   static v8::Local<v8::Value> New(xmlNode *node);
 
+  // the name type() returns for nodes of the given type
+  static v8::Local<v8::Value> type_name(xmlElementType type);
+
+  // keep the counts of the tree roots in step with the tree. Call
+  // unlink_wrapped() before `node` is unlinked from its parent, it must
+  // be wrapped if anything below it is, link_wrapped() once it has been
+  // linked to a new one and free_wrapped() when a wrapped node is freed
+  // by libxml.
+  static void unlink_wrapped(xmlNode *node);
+  static void link_wrapped(xmlNode *node);
+  static void free_wrapped(xmlNode *node);
+
 protected:
+  // the wrapped nodes in the subtree of `node`, itself included
+  static size_t wrapped_subtree(xmlNode *node);
+  void add_tree_wrappers(size_t count);
+  void remove_tree_wrappers(size_t count);
+
   static NAN_METHOD(Doc);
   static NAN_METHOD(Namespace);
   static NAN_METHOD(Namespaces);
@@ -65,6 +89,8 @@ protected:
   void add_next_sibling(xmlNode *element);
   void replace_element(xmlNode *element);
   void replace_text(const char *content);
+  // xmlReplaceNode() keeping the counts of the tree roots
+  void replace_node(xmlNode *node);
   xmlNode *import_node(xmlNode *node);
 };
 
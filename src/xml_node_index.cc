@@ -0,0 +1,276 @@
+// Copyright 2009, Squish Tech, LLC.
+
+#include <algorithm>
+
+#include <libxml/xpath.h>
+
+#include "xml_node_index.h"
+
+namespace libxmljs {
+
+XmlNodeIndex::XmlNodeIndex(xmlDoc *doc)
+    : doc(doc), names_dict(NULL), names_built(false), names_generation(0) {}
+
+XmlNodeIndex::~XmlNodeIndex() {
+  if (names_dict != NULL) {
+    xmlDictFree(names_dict);
+  }
+}
+
+// the value of the attribute
+static std::string attributeValue(xmlAttr *attr) {
+  xmlNode *text = attr->children;
+  if ((text != NULL) && (text->next == NULL) &&
+      (text->type == XML_TEXT_NODE)) {
+    return reinterpret_cast<const char *>(text->content);
+  }
+  xmlChar *value = xmlNodeGetContent(reinterpret_cast<xmlNode *>(attr));
+  std::string result = value ? reinterpret_cast<const char *>(value) : "";
+  xmlFree(value);
+  return result;
+}
+
+void XmlNodeIndex::build_attribute(const std::string &name) {
+  AttributeTable &table = attributes[name];
+  table.elements.clear();
+  table.values.clear();
+
+  std::string::size_type colon = name.find(':');
+  if (colon != std::string::npos) {
+    table.prefix = name.substr(0, colon);
+    table.local = name.substr(colon + 1);
+  } else {
+    table.prefix.clear();
+    table.local = name;
+  }
+
+  eachElement(reinterpret_cast<xmlNode *>(doc),
+              [&](xmlNode *element) { index_element(table, element); });
+}
+
+XmlNodeIndex::AttributeTable &
+XmlNodeIndex::attribute_table(const std::string &name) {
+  std::unordered_map<std::string, AttributeTable>::iterator table =
+      attributes.find(name);
+  if (table == attributes.end()) {
+    build_attribute(name);
+    table = attributes.find(name);
+  }
+  return table->second;
+}
+
+void XmlNodeIndex::index_element(AttributeTable &table, xmlNode *element) {
+  forget_element(table, element);
+
+  const xmlChar *local_name =
+      reinterpret_cast<const xmlChar *>(table.local.c_str());
+  const xmlChar *ns_prefix =
+      table.prefix.empty()
+          ? NULL
+          : reinterpret_cast<const xmlChar *>(table.prefix.c_str());
+
+  for (xmlAttr *attr = element->properties; attr != NULL; attr = attr->next) {
+    if (!xmlStrEqual(attr->name, local_name)) {
+      continue;
+    }
+    if (ns_prefix == NULL ? (attr->ns != NULL)
+                          : (attr->ns == NULL ||
+                             !xmlStrEqual(attr->ns->prefix, ns_prefix))) {
+      continue;
+    }
+
+    std::string value = attributeValue(attr);
+    table.elements[value].push_back(element);
+    table.values.emplace(element, value);
+    return;
+  }
+}
+
+void XmlNodeIndex::forget_element(AttributeTable &table, xmlNode *element) {
+  std::unordered_map<xmlNode *, std::string>::iterator value =
+      table.values.find(element);
+  if (value == table.values.end()) {
+    return;
+  }
+
+  std::unordered_map<std::string, std::vector<xmlNode *>>::iterator filed =
+      table.elements.find(value->second);
+  std::vector<xmlNode *> &elements = filed->second;
+  elements.erase(std::find(elements.begin(), elements.end(), element));
+  if (elements.empty()) {
+    table.elements.erase(filed);
+  }
+  table.values.erase(value);
+}
+
+bool XmlNodeIndex::attached(xmlNode *node) {
+  while (node->parent != NULL) {
+    node = node->parent;
+  }
+  return node == reinterpret_cast<xmlNode *>(doc);
+}
+
+xmlNode *XmlNodeIndex::lookup_attribute(const std::string &name,
+                                        const std::string &value) {
+  AttributeTable &table = attribute_table(name);
+  std::unordered_map<std::string, std::vector<xmlNode *>>::iterator filed =
+      table.elements.find(value);
+  if (filed == table.elements.end()) {
+    return NULL;
+  }
+
+  // first one wins, like getElementById
+  xmlNode *first = NULL;
+  for (xmlNode *element : filed->second) {
+    if (attached(element) &&
+        ((first == NULL) || (xmlXPathCmpNodes(element, first) == 1))) {
+      first = element;
+    }
+  }
+  return first;
+}
+
+void XmlNodeIndex::find_attribute(const std::string &name,
+                                  const std::string &value,
+                                  std::vector<xmlNode *> &found) {
+  AttributeTable &table = attribute_table(name);
+  std::unordered_map<std::string, std::vector<xmlNode *>>::iterator filed =
+      table.elements.find(value);
+  if (filed == table.elements.end()) {
+    return;
+  }
+
+  for (xmlNode *element : filed->second) {
+    if (attached(element)) {
+      found.push_back(element);
+    }
+  }
+  std::sort(found.begin(), found.end(), [](xmlNode *a, xmlNode *b) {
+    return xmlXPathCmpNodes(a, b) == 1;
+  });
+}
+
+void XmlNodeIndex::linked(xmlNode *top) {
+  if (attributes.empty() || !attached(top)) {
+    return;
+  }
+  for (std::pair<const std::string, AttributeTable> &table : attributes) {
+    if (top->type == XML_ELEMENT_NODE) {
+      index_element(table.second, top);
+    }
+    eachElement(top, [&](xmlNode *element) {
+      index_element(table.second, element);
+    });
+  }
+}
+
+void XmlNodeIndex::attributes_changed(xmlNode *element) {
+  for (std::pair<const std::string, AttributeTable> &table : attributes) {
+    index_element(table.second, element);
+  }
+}
+
+void XmlNodeIndex::freed(xmlNode *element) {
+  for (std::pair<const std::string, AttributeTable> &table : attributes) {
+    forget_element(table.second, element);
+  }
+}
+
+void XmlNodeIndex::leaving(xmlNode *top) {
+  for (std::pair<const std::string, AttributeTable> &table : attributes) {
+    if (top->type == XML_ELEMENT_NODE) {
+      forget_element(table.second, top);
+    }
+    eachElement(top, [&](xmlNode *element) {
+      forget_element(table.second, element);
+    });
+  }
+}
+
+void XmlNodeIndex::build_names(unsigned int generation) {
+  if (names_dict == NULL) {
+    names_dict = (doc->dict != NULL) ? xmlDictCreateSub(doc->dict)
+                                     : xmlDictCreate();
+  }
+
+  names.clear();
+  eachElement(reinterpret_cast<xmlNode *>(doc), [&](xmlNode *element) {
+    const xmlChar *name = element->name;
+    if (xmlDictOwns(names_dict, name) != 1) {
+      name = xmlDictLookup(names_dict, name, -1);
+    }
+    names[name].push_back(element);
+  });
+
+  names_built = true;
+  names_generation = generation;
+}
+
+const std::vector<xmlNode *> *
+XmlNodeIndex::elements_named(const xmlChar *name, unsigned int generation) {
+  if (!names_built || (names_generation != generation)) {
+    build_names(generation);
+  }
+
+  // names that were never interned cannot be in the table
+  const xmlChar *key = xmlDictExists(names_dict, name, -1);
+  if (key == NULL) {
+    return NULL;
+  }
+
+  std::unordered_map<const xmlChar *, std::vector<xmlNode *>>::iterator
+      found = names.find(key);
+  return (found != names.end()) ? &found->second : NULL;
+}
+
+// whether node is a descendant of ancestor
+static bool isDescendant(xmlNode *node, xmlNode *ancestor) {
+  for (node = node->parent; node != NULL; node = node->parent) {
+    if (node == ancestor) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool namespaceMatches(xmlNode *element, bool any_ns,
+                             const xmlChar *href) {
+  if (any_ns) {
+    return true;
+  }
+  if (href == NULL) {
+    return element->ns == NULL;
+  }
+  return (element->ns != NULL) && xmlStrEqual(element->ns->href, href);
+}
+
+void XmlNodeIndex::find_elements(const xmlChar *name, xmlNode *within,
+                                 bool any_ns, const xmlChar *href,
+                                 unsigned int generation,
+                                 std::vector<xmlNode *> &found) {
+  // elements removed from the document are not indexed
+  if ((within != NULL) &&
+      !isDescendant(within, reinterpret_cast<xmlNode *>(doc))) {
+    eachElement(within, [&](xmlNode *element) {
+      if (xmlStrEqual(element->name, name) &&
+          namespaceMatches(element, any_ns, href)) {
+        found.push_back(element);
+      }
+    });
+    return;
+  }
+
+  const std::vector<xmlNode *> *elements = elements_named(name, generation);
+  if (elements == NULL) {
+    return;
+  }
+
+  for (xmlNode *element : *elements) {
+    if (namespaceMatches(element, any_ns, href) &&
+        ((within == NULL) || isDescendant(element, within))) {
+      found.push_back(element);
+    }
+  }
+}
+
+} // namespace libxmljs
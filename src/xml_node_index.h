@@ -0,0 +1,125 @@
+// Copyright 2009, Squish Tech, LLC.
+#ifndef SRC_XML_NODE_INDEX_H_
+#define SRC_XML_NODE_INDEX_H_
+
+#include <libxml/dict.h>
+#include <libxml/tree.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace libxmljs {
+
+// the element following `node` in document order among the descendants
+// of `top`, NULL after the last one. Starts with the first descendant
+// when `node` is `top` itself.
+inline xmlNode *nextElement(xmlNode *node, xmlNode *top) {
+  for (;;) {
+    if (((node == top) || (node->type == XML_ELEMENT_NODE)) &&
+        (node->children != NULL)) {
+      node = node->children;
+    } else {
+      while ((node != top) && (node->next == NULL)) {
+        node = node->parent;
+      }
+      if (node == top) {
+        return NULL;
+      }
+      node = node->next;
+    }
+    if (node->type == XML_ELEMENT_NODE) {
+      return node;
+    }
+  }
+}
+
+// call visit() for every element below top, in document order
+template <typename Visitor> void eachElement(xmlNode *top, Visitor visit) {
+  for (xmlNode *node = nextElement(top, top); node != NULL;
+       node = nextElement(node, top)) {
+    visit(node);
+  }
+}
+
+// lookup tables over the elements of a document. Attribute tables are
+// kept up to date as the tree changes, see linked(). The name table
+// remembers the document generation it was built at and is rebuilt
+// lazily once the document has changed since.
+class XmlNodeIndex {
+public:
+  explicit XmlNodeIndex(xmlDoc *doc);
+  ~XmlNodeIndex();
+
+  // (re)build the table for the attribute with the given
+  // (optionally prefixed) name
+  void build_attribute(const std::string &name);
+
+  // first element in document order whose attribute `name` has the
+  // given value, NULL if there is none
+  xmlNode *lookup_attribute(const std::string &name,
+                            const std::string &value);
+
+  // all elements whose attribute `name` has the given value, in
+  // document order
+  void find_attribute(const std::string &name, const std::string &value,
+                      std::vector<xmlNode *> &found);
+
+  // keep the attribute tables in step with the tree: index the subtree
+  // of `top` once it was linked somewhere, reindex an element whose
+  // attributes changed, drop an element that is about to be freed and
+  // the subtree of `top` before it moves to another document.
+  // Unlinking needs no update, lookups skip elements that are no longer
+  // part of the document.
+  void linked(xmlNode *top);
+  void attributes_changed(xmlNode *element);
+  void freed(xmlNode *element);
+  void leaving(xmlNode *top);
+
+  // elements with the given local name in document order, NULL when
+  // there are none
+  const std::vector<xmlNode *> *elements_named(const xmlChar *name,
+                                               unsigned int generation);
+
+  // elements_named() restricted to the descendants of `within` (unless
+  // NULL) and to the namespace `href` (no namespace when NULL) unless
+  // `any_ns` is set
+  void find_elements(const xmlChar *name, xmlNode *within, bool any_ns,
+                     const xmlChar *href, unsigned int generation,
+                     std::vector<xmlNode *> &found);
+
+private:
+  void build_names(unsigned int generation);
+
+  struct AttributeTable {
+    // the attribute name, "prefix:local" matches attributes in a
+    // namespace with that prefix only
+    std::string prefix;
+    std::string local;
+
+    // elements by attribute value, in no particular order
+    std::unordered_map<std::string, std::vector<xmlNode *>> elements;
+
+    // the value each element in `elements` is filed under
+    std::unordered_map<xmlNode *, std::string> values;
+  };
+
+  AttributeTable &attribute_table(const std::string &name);
+  void index_element(AttributeTable &table, xmlNode *element);
+  void forget_element(AttributeTable &table, xmlNode *element);
+  bool attached(xmlNode *node);
+
+  xmlDoc *doc;
+  std::unordered_map<std::string, AttributeTable> attributes;
+
+  // element names interned on top of the dictionary of the document,
+  // so names from the parser are used as keys as is
+  xmlDict *names_dict;
+  bool names_built;
+  unsigned int names_generation;
+  std::unordered_map<const xmlChar *, std::vector<xmlNode *>> names;
+};
+
+} // namespace libxmljs
+
+#endif // SRC_XML_NODE_INDEX_H_
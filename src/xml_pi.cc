@@ -35,6 +35,7 @@ NAN_METHOD(XmlProcessingInstruction::New) {
 
   XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(doc);
   assert(document);
+  DOCUMENT_MUTATION_CHECK(document->xml_obj)
 
   Nan::Utf8String name(info[1]);
 
@@ -69,10 +70,12 @@ NAN_METHOD(XmlProcessingInstruction::Name) {
   XmlProcessingInstruction *processing_instruction =
       Nan::ObjectWrap::Unwrap<XmlProcessingInstruction>(info.This());
   assert(processing_instruction);
+  NODE_DISPOSED_CHECK(processing_instruction)
 
   if (info.Length() == 0)
     return info.GetReturnValue().Set(processing_instruction->get_name());
 
+  DOCUMENT_MUTATION_CHECK(processing_instruction->xml_obj->doc)
   Nan::Utf8String name(Nan::To<String>(info[0]).ToLocalChecked());
   processing_instruction->set_name(*name);
   return info.GetReturnValue().Set(info.This());
@@ -83,10 +86,12 @@ NAN_METHOD(XmlProcessingInstruction::Text) {
   XmlProcessingInstruction *processing_instruction =
       Nan::ObjectWrap::Unwrap<XmlProcessingInstruction>(info.This());
   assert(processing_instruction);
+  NODE_DISPOSED_CHECK(processing_instruction)
 
   if (info.Length() == 0) {
     return info.GetReturnValue().Set(processing_instruction->get_content());
   } else {
+    DOCUMENT_MUTATION_CHECK(processing_instruction->xml_obj->doc)
     processing_instruction->set_content(*Nan::Utf8String(info[0]));
   }
 
@@ -95,6 +100,7 @@ NAN_METHOD(XmlProcessingInstruction::Text) {
 
 void XmlProcessingInstruction::set_name(const char *name) {
   xmlNodeSetName(xml_obj, (const xmlChar *)name);
+  XmlDocument::TreeChanged(xml_obj->doc);
 }
 
 Local<Value> XmlProcessingInstruction::get_name() {
@@ -108,6 +114,7 @@ Local<Value> XmlProcessingInstruction::get_name() {
 
 void XmlProcessingInstruction::set_content(const char *content) {
   xmlNodeSetContent(xml_obj, (xmlChar *)content);
+  XmlDocument::TreeChanged(xml_obj->doc);
 }
 
 Local<Value> XmlProcessingInstruction::get_content() {
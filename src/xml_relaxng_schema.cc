@@ -0,0 +1,79 @@
+// Copyright 2009, Squish Tech, LLC.
+
+#include "xml_relaxng_schema.h"
+#include "xml_document.h"
+#include "xml_syntax_error.h"
+
+using namespace v8;
+
+namespace libxmljs {
+
+Nan::Persistent<FunctionTemplate> XmlRelaxNGSchema::constructor_template;
+
+// doc
+NAN_METHOD(XmlRelaxNGSchema::New) {
+  NAN_CONSTRUCTOR_CHECK(RelaxNGSchema)
+  Nan::HandleScope scope;
+
+  DOCUMENT_ARG_CHECK
+
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(doc);
+  assert(document);
+
+  Local<Array> errors = Nan::New<Array>();
+  xmlResetLastError();
+  xmlSetStructuredErrorFunc(reinterpret_cast<void *>(&errors),
+                            XmlSyntaxError::PushToArray);
+
+  xmlRelaxNGParserCtxtPtr parser_ctxt =
+      xmlRelaxNGNewDocParserCtxt(document->xml_obj);
+  if (parser_ctxt == NULL) {
+    xmlSetStructuredErrorFunc(NULL, NULL);
+    return Nan::ThrowError(
+        "Could not create context for RELAX NG schema parser");
+  }
+
+  xmlRelaxNGPtr schema = xmlRelaxNGParse(parser_ctxt);
+  xmlRelaxNGFreeParserCtxt(parser_ctxt);
+  xmlSetStructuredErrorFunc(NULL, NULL);
+
+  if (schema == NULL) {
+    return Nan::ThrowError("Invalid RELAX NG schema");
+  }
+
+  // the parser works on its own copy of the document, the compiled
+  // grammar doesn't point into the one passed in
+  XmlRelaxNGSchema *compiled = new XmlRelaxNGSchema(schema);
+  compiled->Wrap(info.This());
+
+  Nan::Set(info.This(), Nan::New<String>("errors").ToLocalChecked(), errors)
+      .Check();
+
+  return info.GetReturnValue().Set(info.This());
+}
+
+// compiled grammars are long lived and can be large (interleave in
+// particular), so let the GC know about them straight away
+XmlRelaxNGSchema::XmlRelaxNGSchema(xmlRelaxNG *schema) : xml_obj(schema) {
+  syncExternalMemory();
+}
+
+XmlRelaxNGSchema::~XmlRelaxNGSchema() {
+  xmlRelaxNGFree(xml_obj);
+  syncExternalMemory();
+}
+
+void XmlRelaxNGSchema::Initialize(Local<Object> target) {
+  Nan::HandleScope scope;
+
+  Local<FunctionTemplate> tmpl = Nan::New<FunctionTemplate>(New);
+  tmpl->SetClassName(Nan::New<String>("RelaxNGSchema").ToLocalChecked());
+
+  constructor_template.Reset(tmpl);
+  tmpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::Set(target, Nan::New<String>("RelaxNGSchema").ToLocalChecked(),
+           Nan::GetFunction(tmpl).ToLocalChecked());
+}
+
+} // namespace libxmljs
@@ -0,0 +1,30 @@
+// Copyright 2009, Squish Tech, LLC.
+#ifndef SRC_XML_RELAXNG_SCHEMA_H_
+#define SRC_XML_RELAXNG_SCHEMA_H_
+
+#include <libxml/relaxng.h>
+
+#include "libxmljs.h"
+
+namespace libxmljs {
+
+// a compiled RELAX NG grammar, reusable across any number of validations
+class XmlRelaxNGSchema : public Nan::ObjectWrap {
+public:
+  static Nan::Persistent<v8::FunctionTemplate> constructor_template;
+
+  xmlRelaxNG *xml_obj;
+
+  virtual ~XmlRelaxNGSchema();
+
+  static void Initialize(v8::Local<v8::Object> target);
+
+protected:
+  explicit XmlRelaxNGSchema(xmlRelaxNG *schema);
+
+  static NAN_METHOD(New);
+};
+
+} // namespace libxmljs
+
+#endif // SRC_XML_RELAXNG_SCHEMA_H_
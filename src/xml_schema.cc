@@ -0,0 +1,85 @@
+// Copyright 2009, Squish Tech, LLC.
+
+#include "xml_schema.h"
+#include "xml_document.h"
+#include "xml_syntax_error.h"
+
+using namespace v8;
+
+namespace libxmljs {
+
+Nan::Persistent<FunctionTemplate> XmlSchema::constructor_template;
+
+// doc
+NAN_METHOD(XmlSchema::New) {
+  NAN_CONSTRUCTOR_CHECK(Schema)
+  Nan::HandleScope scope;
+
+  DOCUMENT_ARG_CHECK
+
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(doc);
+  assert(document);
+
+  // compiling rewrites the document it reads, leave the one passed in
+  // alone and compile from a copy owned by the schema
+  xmlDoc *copy = xmlCopyDoc(document->xml_obj, 1);
+  if (copy == NULL) {
+    return Nan::ThrowError("Could not copy the schema document");
+  }
+
+  Local<Array> errors = Nan::New<Array>();
+  xmlResetLastError();
+  xmlSetStructuredErrorFunc(reinterpret_cast<void *>(&errors),
+                            XmlSyntaxError::PushToArray);
+
+  xmlSchemaParserCtxtPtr parser_ctxt = xmlSchemaNewDocParserCtxt(copy);
+  if (parser_ctxt == NULL) {
+    xmlSetStructuredErrorFunc(NULL, NULL);
+    xmlFreeDoc(copy);
+    return Nan::ThrowError("Could not create context for schema parser");
+  }
+
+  xmlSchemaPtr schema = xmlSchemaParse(parser_ctxt);
+  xmlSchemaFreeParserCtxt(parser_ctxt);
+  xmlSetStructuredErrorFunc(NULL, NULL);
+
+  if (schema == NULL) {
+    xmlFreeDoc(copy);
+    return Nan::ThrowError("Invalid XSD schema");
+  }
+
+  XmlSchema *compiled = new XmlSchema(schema, copy);
+  compiled->Wrap(info.This());
+
+  Nan::Set(info.This(), Nan::New<String>("errors").ToLocalChecked(), errors)
+      .Check();
+
+  return info.GetReturnValue().Set(info.This());
+}
+
+// compiled schemas are long lived, let the GC know about them straight away
+XmlSchema::XmlSchema(xmlSchema *schema, xmlDoc *doc)
+    : xml_obj(schema), doc(doc) {
+  syncExternalMemory();
+}
+
+XmlSchema::~XmlSchema() {
+  xmlSchemaFree(xml_obj);
+  xmlFreeDoc(doc);
+  syncExternalMemory();
+}
+
+void XmlSchema::Initialize(Local<Object> target) {
+  Nan::HandleScope scope;
+
+  Local<FunctionTemplate> tmpl = Nan::New<FunctionTemplate>(New);
+  tmpl->SetClassName(Nan::New<String>("Schema").ToLocalChecked());
+
+  constructor_template.Reset(tmpl);
+  tmpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::Set(target, Nan::New<String>("Schema").ToLocalChecked(),
+           Nan::GetFunction(tmpl).ToLocalChecked());
+}
+
+} // namespace libxmljs
@@ -0,0 +1,34 @@
+// Copyright 2009, Squish Tech, LLC.
+#ifndef SRC_XML_SCHEMA_H_
+#define SRC_XML_SCHEMA_H_
+
+#include <libxml/xmlschemas.h>
+
+#include "libxmljs.h"
+
+namespace libxmljs {
+
+// a compiled XSD schema, reusable across any number of validations
+class XmlSchema : public Nan::ObjectWrap {
+public:
+  static Nan::Persistent<v8::FunctionTemplate> constructor_template;
+
+  xmlSchema *xml_obj;
+
+  // private copy of the document the schema was compiled from, the
+  // compiled schema points into it
+  xmlDoc *doc;
+
+  virtual ~XmlSchema();
+
+  static void Initialize(v8::Local<v8::Object> target);
+
+protected:
+  XmlSchema(xmlSchema *schema, xmlDoc *doc);
+
+  static NAN_METHOD(New);
+};
+
+} // namespace libxmljs
+
+#endif // SRC_XML_SCHEMA_H_
@@ -0,0 +1,100 @@
+// Copyright 2009, Squish Tech, LLC.
+
+#include "xml_schematron_schema.h"
+#include "xml_document.h"
+#include "xml_syntax_error.h"
+
+using namespace v8;
+
+namespace libxmljs {
+
+Nan::Persistent<FunctionTemplate> XmlSchematronSchema::constructor_template;
+
+// doc
+NAN_METHOD(XmlSchematronSchema::New) {
+  NAN_CONSTRUCTOR_CHECK(SchematronSchema)
+  Nan::HandleScope scope;
+
+  DOCUMENT_ARG_CHECK
+
+  XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(doc);
+  assert(document);
+
+  // the compiled schema points into the document it was compiled from,
+  // compile from a copy owned by the schema so the one passed in stays
+  // free to change
+  xmlDoc *copy = xmlCopyDoc(document->xml_obj, 1);
+  if (copy == NULL) {
+    return Nan::ThrowError("Could not copy the schema document");
+  }
+
+  Local<Array> errors = Nan::New<Array>();
+  xmlResetLastError();
+  xmlSetStructuredErrorFunc(reinterpret_cast<void *>(&errors),
+                            XmlSyntaxError::PushToArray);
+
+  xmlSchematronParserCtxtPtr parser_ctxt = xmlSchematronNewDocParserCtxt(copy);
+  if (parser_ctxt == NULL) {
+    xmlSetStructuredErrorFunc(NULL, NULL);
+    xmlFreeDoc(copy);
+    return Nan::ThrowError(
+        "Could not create context for Schematron schema parser");
+  }
+
+  xmlSchematronPtr schema = xmlSchematronParse(parser_ctxt);
+  xmlSchematronFreeParserCtxt(parser_ctxt);
+  xmlSetStructuredErrorFunc(NULL, NULL);
+
+  if (schema == NULL) {
+    xmlFreeDoc(copy);
+    return Nan::ThrowError("Invalid Schematron schema");
+  }
+
+  xmlSchematronValidCtxtPtr valid_ctxt =
+      xmlSchematronNewValidCtxt(schema, XML_SCHEMATRON_OUT_ERROR);
+  if (valid_ctxt == NULL) {
+    xmlSchematronFree(schema);
+    xmlFreeDoc(copy);
+    return Nan::ThrowError(
+        "Unable to create a validation context for the Schematron schema");
+  }
+
+  XmlSchematronSchema *compiled =
+      new XmlSchematronSchema(schema, valid_ctxt, copy);
+  compiled->Wrap(info.This());
+
+  Nan::Set(info.This(), Nan::New<String>("errors").ToLocalChecked(), errors)
+      .Check();
+
+  return info.GetReturnValue().Set(info.This());
+}
+
+// compiled schemas are long lived, let the GC know about them straight away
+XmlSchematronSchema::XmlSchematronSchema(xmlSchematron *schema,
+                                         xmlSchematronValidCtxt *valid_ctxt,
+                                         xmlDoc *doc)
+    : xml_obj(schema), valid_ctxt(valid_ctxt), doc(doc) {
+  syncExternalMemory();
+}
+
+XmlSchematronSchema::~XmlSchematronSchema() {
+  xmlSchematronFreeValidCtxt(valid_ctxt);
+  xmlSchematronFree(xml_obj);
+  xmlFreeDoc(doc);
+  syncExternalMemory();
+}
+
+void XmlSchematronSchema::Initialize(Local<Object> target) {
+  Nan::HandleScope scope;
+
+  Local<FunctionTemplate> tmpl = Nan::New<FunctionTemplate>(New);
+  tmpl->SetClassName(Nan::New<String>("SchematronSchema").ToLocalChecked());
+
+  constructor_template.Reset(tmpl);
+  tmpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::Set(target, Nan::New<String>("SchematronSchema").ToLocalChecked(),
+           Nan::GetFunction(tmpl).ToLocalChecked());
+}
+
+} // namespace libxmljs
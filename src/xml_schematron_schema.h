@@ -0,0 +1,40 @@
+// Copyright 2009, Squish Tech, LLC.
+#ifndef SRC_XML_SCHEMATRON_SCHEMA_H_
+#define SRC_XML_SCHEMATRON_SCHEMA_H_
+
+#include <libxml/schematron.h>
+
+#include "libxmljs.h"
+
+namespace libxmljs {
+
+// a compiled Schematron schema, including its compiled XPath assertions
+class XmlSchematronSchema : public Nan::ObjectWrap {
+public:
+  static Nan::Persistent<v8::FunctionTemplate> constructor_template;
+
+  xmlSchematron *xml_obj;
+
+  // validation context reused by every (synchronous) validation,
+  // only the error handler changes between calls
+  xmlSchematronValidCtxt *valid_ctxt;
+
+  // private copy of the document the schema was compiled from, the
+  // compiled schema points into it
+  xmlDoc *doc;
+
+  virtual ~XmlSchematronSchema();
+
+  static void Initialize(v8::Local<v8::Object> target);
+
+protected:
+  XmlSchematronSchema(xmlSchematron *schema,
+                      xmlSchematronValidCtxt *valid_ctxt,
+                      xmlDoc *doc);
+
+  static NAN_METHOD(New);
+};
+
+} // namespace libxmljs
+
+#endif // SRC_XML_SCHEMATRON_SCHEMA_H_
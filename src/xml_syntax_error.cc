@@ -63,4 +63,27 @@ void XmlSyntaxError::PushToArray(void *errs, xmlError *error) {
   Nan::Call(push, errors, 1, argv);
 }
 
+void XmlSyntaxError::CopyToVector(void *errs, xmlError *error) {
+  std::vector<xmlError> *errors =
+      reinterpret_cast<std::vector<xmlError> *>(errs);
+
+  xmlError copy;
+  memset(&copy, 0, sizeof(copy));
+  xmlCopyError(error, &copy);
+  errors->push_back(copy);
+}
+
+Local<Array> XmlSyntaxError::BuildSyntaxErrors(std::vector<xmlError> *errors) {
+  Nan::EscapableHandleScope scope;
+  Local<Array> out = Nan::New<Array>(static_cast<int>(errors->size()));
+
+  for (uint32_t i = 0; i < errors->size(); ++i) {
+    Nan::Set(out, i, XmlSyntaxError::BuildSyntaxError(&(*errors)[i]));
+    xmlResetError(&(*errors)[i]);
+  }
+  errors->clear();
+
+  return scope.Escape(out);
+}
+
 } // namespace libxmljs
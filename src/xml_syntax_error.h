@@ -4,6 +4,8 @@
 
 #include <libxml/xmlerror.h>
 
+#include <vector>
+
 #include "libxmljs.h"
 
 namespace libxmljs {
@@ -18,6 +20,14 @@ public:
   // create a v8 object for the syntax eror
   // TODO make it a v8 Erorr object
   static v8::Local<v8::Value> BuildSyntaxError(xmlError *error);
+
+  // copy xmlError onto a std::vector<xmlError>
+  // used where errors are raised off the main thread
+  static void CopyToVector(void *errs, xmlError *error);
+
+  // create a v8 array from errors collected with CopyToVector
+  // the copies are released and the vector is emptied
+  static v8::Local<v8::Array> BuildSyntaxErrors(std::vector<xmlError> *errors);
 };
 
 } // namespace libxmljs
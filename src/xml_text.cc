@@ -47,6 +47,7 @@ NAN_METHOD(XmlText::New) {
 
   XmlDocument *document = Nan::ObjectWrap::Unwrap<XmlDocument>(doc);
   assert(document);
+  DOCUMENT_MUTATION_CHECK(document->xml_obj)
 
   Local<Value> contentOpt;
   if (info[1]->IsString()) {
@@ -74,6 +75,7 @@ NAN_METHOD(XmlText::NextElement) {
   Nan::HandleScope scope;
   XmlText *element = Nan::ObjectWrap::Unwrap<XmlText>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   return info.GetReturnValue().Set(element->get_next_element());
 }
@@ -82,6 +84,7 @@ NAN_METHOD(XmlText::PrevElement) {
   Nan::HandleScope scope;
   XmlText *element = Nan::ObjectWrap::Unwrap<XmlText>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   return info.GetReturnValue().Set(element->get_prev_element());
 }
@@ -90,10 +93,12 @@ NAN_METHOD(XmlText::Text) {
   Nan::HandleScope scope;
   XmlText *element = Nan::ObjectWrap::Unwrap<XmlText>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
 
   if (info.Length() == 0) {
     return info.GetReturnValue().Set(element->get_content());
   } else {
+    DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
     element->set_content(*Nan::Utf8String(info[0]));
   }
 
@@ -103,10 +108,13 @@ NAN_METHOD(XmlText::Text) {
 NAN_METHOD(XmlText::AddPrevSibling) {
   XmlText *text = Nan::ObjectWrap::Unwrap<XmlText>(info.This());
   assert(text);
+  NODE_DISPOSED_CHECK(text)
+  DOCUMENT_MUTATION_CHECK(text->xml_obj->doc)
 
   XmlNode *new_sibling = Nan::ObjectWrap::Unwrap<XmlNode>(
       Nan::To<Object>(info[0]).ToLocalChecked());
   assert(new_sibling);
+  NODE_DISPOSED_CHECK(new_sibling)
 
   xmlNode *imported_sibling = text->import_node(new_sibling->xml_obj);
   if (imported_sibling == NULL) {
@@ -124,10 +132,13 @@ NAN_METHOD(XmlText::AddPrevSibling) {
 NAN_METHOD(XmlText::AddNextSibling) {
   XmlText *text = Nan::ObjectWrap::Unwrap<XmlText>(info.This());
   assert(text);
+  NODE_DISPOSED_CHECK(text)
+  DOCUMENT_MUTATION_CHECK(text->xml_obj->doc)
 
   XmlNode *new_sibling = Nan::ObjectWrap::Unwrap<XmlNode>(
       Nan::To<Object>(info[0]).ToLocalChecked());
   assert(new_sibling);
+  NODE_DISPOSED_CHECK(new_sibling)
 
   xmlNode *imported_sibling = text->import_node(new_sibling->xml_obj);
   if (imported_sibling == NULL) {
@@ -145,6 +156,8 @@ NAN_METHOD(XmlText::AddNextSibling) {
 NAN_METHOD(XmlText::Replace) {
   XmlText *element = Nan::ObjectWrap::Unwrap<XmlText>(info.This());
   assert(element);
+  NODE_DISPOSED_CHECK(element)
+  DOCUMENT_MUTATION_CHECK(element->xml_obj->doc)
 
   if (info[0]->IsString()) {
     element->replace_text(*Nan::Utf8String(info[0]));
@@ -152,6 +165,7 @@ NAN_METHOD(XmlText::Replace) {
     XmlText *new_sibling = Nan::ObjectWrap::Unwrap<XmlText>(
         Nan::To<Object>(info[0]).ToLocalChecked());
     assert(new_sibling);
+    NODE_DISPOSED_CHECK(new_sibling)
 
     xmlNode *imported_sibling = element->import_node(new_sibling->xml_obj);
     if (imported_sibling == NULL) {
@@ -168,6 +182,7 @@ NAN_METHOD(XmlText::Path) {
   Nan::HandleScope scope;
   XmlText *text = Nan::ObjectWrap::Unwrap<XmlText>(info.This());
   assert(text);
+  NODE_DISPOSED_CHECK(text)
 
   return info.GetReturnValue().Set(text->get_path());
 }
@@ -176,6 +191,7 @@ NAN_METHOD(XmlText::Name) {
   Nan::HandleScope scope;
   XmlText *text = Nan::ObjectWrap::Unwrap<XmlText>(info.This());
   assert(text);
+  NODE_DISPOSED_CHECK(text)
 
   if (info.Length() == 0)
     return info.GetReturnValue().Set(text->get_name());
@@ -187,6 +203,7 @@ void XmlText::set_content(const char *content) {
       xmlEncodeSpecialChars(xml_obj->doc, (const xmlChar *)content);
   xmlNodeSetContent(xml_obj, encoded);
   xmlFree(encoded);
+  XmlDocument::TreeChanged(xml_obj->doc);
 }
 
 Local<Value> XmlText::get_content() {
@@ -264,20 +281,26 @@ Local<Object> XmlText::New(xmlNode *node) {
 XmlText::XmlText(xmlNode *node) : XmlNode(node) {}
 
 void XmlText::add_prev_sibling(xmlNode *element) {
-  xmlAddPrevSibling(xml_obj, element);
+  if (xmlAddPrevSibling(xml_obj, element) == element) {
+    link_wrapped(element);
+    XmlDocument::NodeLinked(element);
+  }
+  XmlDocument::TreeChanged(xml_obj->doc);
 }
 
 void XmlText::add_next_sibling(xmlNode *element) {
-  xmlAddNextSibling(xml_obj, element);
+  if (xmlAddNextSibling(xml_obj, element) == element) {
+    link_wrapped(element);
+    XmlDocument::NodeLinked(element);
+  }
+  XmlDocument::TreeChanged(xml_obj->doc);
 }
 
-void XmlText::replace_element(xmlNode *element) {
-  xmlReplaceNode(xml_obj, element);
-}
+void XmlText::replace_element(xmlNode *element) { replace_node(element); }
 
 void XmlText::replace_text(const char *content) {
   xmlNodePtr txt = xmlNewDocText(xml_obj->doc, (const xmlChar *)content);
-  xmlReplaceNode(xml_obj, txt);
+  replace_node(txt);
 }
 
 bool XmlText::next_sibling_will_merge(xmlNode *child) {
@@ -1,69 +1,402 @@
 // Copyright 2009, Squish Tech, LLC.
 
+#include <libxml/hash.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
 
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "xml_document.h"
 #include "xml_element.h"
 #include "xml_xpath_context.h"
+#include "xml_xpath_expression.h"
 
 using namespace v8;
 
 namespace libxmljs {
 
-XmlXpathContext::XmlXpathContext(xmlNode *node) {
-  ctxt = xmlXPathNewContext(node->doc);
+// Compiled expressions, most recently used first. Expressions are
+// compiled without a context so they can be evaluated against any
+// document, namespace prefixes are only resolved at evaluation time.
+typedef std::pair<std::string, xmlXPathCompExpr *> CompiledXPath;
+typedef std::list<CompiledXPath> CompiledXPathList;
+
+static CompiledXPathList xpath_cache;
+static std::unordered_map<std::string, CompiledXPathList::iterator>
+    xpath_cache_index;
+static size_t xpath_cache_capacity = 256;
+static double xpath_cache_hits = 0;
+static double xpath_cache_misses = 0;
+
+static void trimXPathCache(size_t capacity) {
+  while (xpath_cache.size() > capacity) {
+    xpath_cache_index.erase(xpath_cache.back().first);
+    xmlXPathFreeCompExpr(xpath_cache.back().second);
+    xpath_cache.pop_back();
+  }
+}
+
+xmlXPathCompExpr *XmlXpathContext::compile(const xmlChar *xpath,
+                                           bool *cached) {
+  std::string key(reinterpret_cast<const char *>(xpath));
+
+  std::unordered_map<std::string, CompiledXPathList::iterator>::iterator
+      found = xpath_cache_index.find(key);
+  if (found != xpath_cache_index.end()) {
+    xpath_cache_hits++;
+    xpath_cache.splice(xpath_cache.begin(), xpath_cache, found->second);
+    *cached = true;
+    return found->second->second;
+  }
+
+  xpath_cache_misses++;
+  xmlXPathCompExpr *comp = xmlXPathCompile(xpath);
+  *cached = (comp != NULL) && (xpath_cache_capacity > 0);
+  if (*cached) {
+    trimXPathCache(xpath_cache_capacity - 1);
+    xpath_cache.push_front(CompiledXPath(key, comp));
+    xpath_cache_index[key] = xpath_cache.begin();
+  }
+  return comp;
+}
+
+// size
+NAN_METHOD(XmlXpathContext::SetCacheSize) {
+  Nan::HandleScope scope;
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsNumber,
+                               "Bad argument: size must be a number");
+
+  // NaN, Infinity and sizes past what a double holds exactly don't
+  // convert to a size_t
+  double size = Nan::To<double>(info[0]).FromJust();
+  if (!(size >= 0)) {
+    return Nan::ThrowRangeError("Bad argument: size must not be negative");
+  }
+  if (!(size <= 9007199254740991.0)) {
+    return Nan::ThrowRangeError(
+        "Bad argument: size must be at most Number.MAX_SAFE_INTEGER");
+  }
+
+  xpath_cache_capacity = static_cast<size_t>(size);
+  trimXPathCache(xpath_cache_capacity);
+}
+
+NAN_METHOD(XmlXpathContext::CacheStats) {
+  Nan::HandleScope scope;
+
+  Local<Object> stats = Nan::New<Object>();
+  Nan::Set(stats, Nan::New<String>("size").ToLocalChecked(),
+           Nan::New<Number>(static_cast<double>(xpath_cache.size())));
+  Nan::Set(stats, Nan::New<String>("capacity").ToLocalChecked(),
+           Nan::New<Number>(static_cast<double>(xpath_cache_capacity)));
+  Nan::Set(stats, Nan::New<String>("hits").ToLocalChecked(),
+           Nan::New<Number>(xpath_cache_hits));
+  Nan::Set(stats, Nan::New<String>("misses").ToLocalChecked(),
+           Nan::New<Number>(xpath_cache_misses));
+
+  return info.GetReturnValue().Set(stats);
+}
+
+void XmlXpathContext::Initialize(Local<Object> target) {
+  Nan::HandleScope scope;
+
+  Nan::SetMethod(target, "xpathCacheSize", XmlXpathContext::SetCacheSize);
+  Nan::SetMethod(target, "xpathCacheStats", XmlXpathContext::CacheStats);
+}
+
+XmlXpathContext::XmlXpathContext(xmlNode *node)
+    : owned(true), has_variables(false) {
+  XmlDocument *document =
+      (node->doc != NULL) ? static_cast<XmlDocument *>(node->doc->_private)
+                          : NULL;
+
+  // reuse the context (and registered namespaces) of the document,
+  // only the evaluation state needs resetting
+  if ((document != NULL) && (document->xpath_ctxt != NULL)) {
+    ctxt = document->xpath_ctxt;
+    ctxt->contextSize = -1;
+    ctxt->proximityPosition = -1;
+    owned = false;
+  } else {
+    ctxt = xmlXPathNewContext(node->doc);
+  }
   ctxt->node = node;
 }
 
-XmlXpathContext::~XmlXpathContext() { xmlXPathFreeContext(ctxt); }
+XmlXpathContext::~XmlXpathContext() {
+  if (owned) {
+    xmlXPathFreeContext(ctxt);
+  } else if (has_variables) {
+    xmlXPathRegisteredVariablesCleanup(ctxt);
+  }
+}
+
+static void copyXPathNamespace(void *uri, void *ctxt, const xmlChar *prefix) {
+  xmlXPathRegisterNs(static_cast<xmlXPathContext *>(ctxt), prefix,
+                     static_cast<const xmlChar *>(uri));
+}
 
 void XmlXpathContext::register_ns(const xmlChar *prefix, const xmlChar *uri) {
+  // namespaces passed to a single query must not stick to the shared
+  // context, so work on a private copy of it from here on
+  if (!owned) {
+    xmlXPathContext *shared = ctxt;
+    ctxt = xmlXPathNewContext(shared->doc);
+    ctxt->node = shared->node;
+    if (shared->nsHash != NULL) {
+      xmlHashScan(shared->nsHash, copyXPathNamespace, ctxt);
+    }
+    owned = true;
+  }
   xmlXPathRegisterNs(ctxt, prefix, uri);
 }
 
-Local<Value> XmlXpathContext::evaluate(const xmlChar *xpath) {
+void XmlXpathContext::register_namespaces(Local<Value> namespaces) {
+  if (namespaces->IsString()) {
+    Nan::Utf8String uri(namespaces);
+    register_ns((const xmlChar *)"xmlns", (const xmlChar *)*uri);
+  } else if (namespaces->IsObject()) {
+    Local<Object> map = Nan::To<Object>(namespaces).ToLocalChecked();
+    Local<Array> properties = Nan::GetPropertyNames(map).ToLocalChecked();
+    for (unsigned int i = 0; i < properties->Length(); i++) {
+      Local<String> prop_name =
+          Nan::To<String>(
+              Nan::Get(properties, Nan::New<Number>(i)).ToLocalChecked())
+              .ToLocalChecked();
+      Nan::Utf8String prefix(prop_name);
+      Nan::Utf8String uri(Nan::Get(map, prop_name).ToLocalChecked());
+      register_ns((const xmlChar *)*prefix, (const xmlChar *)*uri);
+    }
+  }
+}
+
+// the xpath value of a variable, NULL if it can't be represented
+static xmlXPathObject *toXPathObject(Local<Value> value) {
+  Local<FunctionTemplate> node_tmpl =
+      Nan::New(XmlNode::constructor_template);
+
+  if (value->IsNumber()) {
+    return xmlXPathNewFloat(Nan::To<double>(value).FromJust());
+  } else if (value->IsBoolean()) {
+    return xmlXPathNewBoolean(Nan::To<bool>(value).FromJust());
+  } else if (node_tmpl->HasInstance(value)) {
+    XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(
+        Nan::To<Object>(value).ToLocalChecked());
+    return xmlXPathNewNodeSet(node->xml_obj);
+  } else if (value->IsArray()) {
+    Local<Array> array = value.As<Array>();
+    xmlXPathObject *set = xmlXPathNewNodeSet(NULL);
+    for (uint32_t i = 0; i < array->Length(); ++i) {
+      Local<Value> item = Nan::Get(array, i).ToLocalChecked();
+      if (!node_tmpl->HasInstance(item)) {
+        xmlXPathFreeObject(set);
+        return NULL;
+      }
+      XmlNode *node = Nan::ObjectWrap::Unwrap<XmlNode>(
+          Nan::To<Object>(item).ToLocalChecked());
+      if (node->xml_obj != NULL) {
+        xmlXPathNodeSetAdd(set->nodesetval, node->xml_obj);
+      }
+    }
+    return set;
+  } else if (value->IsString()) {
+    Nan::Utf8String str(value);
+    return xmlXPathNewString((const xmlChar *)*str);
+  }
+  return NULL;
+}
+
+bool XmlXpathContext::register_variables(Local<Value> variables) {
+  if (!variables->IsObject()) {
+    return true;
+  }
+
+  Local<Object> map = Nan::To<Object>(variables).ToLocalChecked();
+  Local<Array> properties = Nan::GetPropertyNames(map).ToLocalChecked();
+  for (unsigned int i = 0; i < properties->Length(); i++) {
+    Local<String> prop_name =
+        Nan::To<String>(
+            Nan::Get(properties, Nan::New<Number>(i)).ToLocalChecked())
+            .ToLocalChecked();
+    Nan::Utf8String name(prop_name);
+    xmlXPathObject *value =
+        toXPathObject(Nan::Get(map, prop_name).ToLocalChecked());
+    if (value == NULL) {
+      std::string message = std::string("Unsupported value for variable $") +
+                            *name +
+                            ", expected a string, number, boolean, node or "
+                            "array of nodes";
+      Nan::ThrowTypeError(message.c_str());
+      return false;
+    }
+
+    // the context takes ownership of the value
+    xmlXPathRegisterVariable(ctxt, (const xmlChar *)*name, value);
+    has_variables = true;
+  }
+  return true;
+}
+
+xmlXPathObject *XmlXpathContext::evaluate_object(Local<Value> xpath) {
+  // a compiled expression skips the string handling and cache lookup
+  if (XmlXPathExpression::constructor_template.Get(Isolate::GetCurrent())
+          ->HasInstance(xpath)) {
+    XmlXPathExpression *expression =
+        Nan::ObjectWrap::Unwrap<XmlXPathExpression>(
+            Nan::To<Object>(xpath).ToLocalChecked());
+    return xmlXPathCompiledEval(expression->xml_obj, ctxt);
+  }
+
+  Nan::Utf8String str(xpath);
+  bool cached;
+  xmlXPathCompExpr *comp = compile((const xmlChar *)*str, &cached);
+  xmlXPathObject *xpathobj = xmlXPathCompiledEval(comp, ctxt);
+  if (!cached) {
+    xmlXPathFreeCompExpr(comp);
+  }
+  return xpathobj;
+}
+
+Local<Value> XmlXpathContext::evaluate(Local<Value> xpath, ResultMode mode) {
   Nan::EscapableHandleScope scope;
-  xmlXPathObject *xpathobj = xmlXPathEval(xpath, ctxt);
+  xmlXPathObject *xpathobj = evaluate_object(xpath);
+
+  // invalid expressions and evaluation errors yield undefined
+  if (xpathobj == NULL) {
+    return scope.Escape(Nan::Undefined());
+  }
+
   Local<Value> res;
+  switch (mode) {
+  case RESULT_STRING: {
+    xmlChar *str = xmlXPathCastToString(xpathobj);
+    res = Nan::New<String>((const char *)str, xmlStrlen(str)).ToLocalChecked();
+    xmlFree(str);
+    break;
+  }
 
-  if (xpathobj) {
-    switch (xpathobj->type) {
-    case XPATH_NODESET: {
-      if (xmlXPathNodeSetIsEmpty(xpathobj->nodesetval)) {
-        res = Nan::New<Array>(0);
-        break;
-      }
+  case RESULT_NUMBER:
+    res = Nan::New<Number>(xmlXPathCastToNumber(xpathobj));
+    break;
 
-      Local<Array> nodes = Nan::New<Array>(xpathobj->nodesetval->nodeNr);
-      for (int i = 0; i != xpathobj->nodesetval->nodeNr; ++i) {
-        Nan::Set(nodes, i, XmlNode::New(xpathobj->nodesetval->nodeTab[i]));
-      }
+  case RESULT_STRINGS:
+  case RESULT_ATTR_VALUES:
+  case RESULT_COUNT:
+    if (xpathobj->type != XPATH_NODESET) {
+      Nan::ThrowError("XPath expression must select a node set");
+      res = Nan::Undefined();
+    } else if (mode == RESULT_COUNT) {
+      res = Nan::New<Number>(xmlXPathNodeSetGetLength(xpathobj->nodesetval));
+    } else {
+      res = to_strings(xpathobj->nodesetval, mode == RESULT_ATTR_VALUES);
+    }
+    break;
 
-      res = nodes;
-      break;
+  default:
+    res = to_value(xpathobj);
+    break;
+  }
+
+  xmlXPathFreeObject(xpathobj);
+  return scope.Escape(res);
+}
+
+// the string-value of a node, without copying it where that's possible
+static Local<String> nodeStringValue(xmlNode *node) {
+  Nan::EscapableHandleScope scope;
+  const xmlChar *content = NULL;
+
+  switch (node->type) {
+  case XML_TEXT_NODE:
+  case XML_CDATA_SECTION_NODE:
+  case XML_COMMENT_NODE:
+  case XML_PI_NODE:
+    content = node->content;
+    break;
+  case XML_ATTRIBUTE_NODE:
+    if (node->children == NULL) {
+      content = (const xmlChar *)"";
+    } else if ((node->children->next == NULL) &&
+               (node->children->type == XML_TEXT_NODE)) {
+      content = node->children->content;
     }
+    break;
+  default:
+    break;
+  }
 
-    case XPATH_BOOLEAN:
-      res = Nan::New<Boolean>(xpathobj->boolval);
-      break;
+  if (content != NULL) {
+    return scope.Escape(
+        Nan::New<String>((const char *)content, xmlStrlen(content))
+            .ToLocalChecked());
+  }
 
-    case XPATH_NUMBER:
-      res = Nan::New<Number>(xpathobj->floatval);
-      break;
+  xmlChar *value = xmlXPathCastNodeToString(node);
+  Local<String> str =
+      Nan::New<String>((const char *)value, xmlStrlen(value)).ToLocalChecked();
+  xmlFree(value);
+  return scope.Escape(str);
+}
 
-    case XPATH_STRING:
-      res = Nan::New<String>((const char *)xpathobj->stringval,
-                             xmlStrlen(xpathobj->stringval))
-                .ToLocalChecked();
-      break;
+Local<Value> XmlXpathContext::to_strings(xmlNodeSet *nodes, bool attrs_only) {
+  Nan::EscapableHandleScope scope;
+  int length = xmlXPathNodeSetGetLength(nodes);
+  Local<Array> strings = Nan::New<Array>(attrs_only ? 0 : length);
+
+  uint32_t index = 0;
+  for (int i = 0; i < length; ++i) {
+    xmlNode *node = nodes->nodeTab[i];
+    if (attrs_only && (node->type != XML_ATTRIBUTE_NODE)) {
+      continue;
+    }
+    Nan::Set(strings, index++, nodeStringValue(node));
+  }
+
+  return scope.Escape(strings);
+}
 
-    default:
-      res = Nan::Null();
+Local<Value> XmlXpathContext::to_value(xmlXPathObject *xpathobj) {
+  Nan::EscapableHandleScope scope;
+  Local<Value> res;
+
+  switch (xpathobj->type) {
+  case XPATH_NODESET: {
+    if (xmlXPathNodeSetIsEmpty(xpathobj->nodesetval)) {
+      res = Nan::New<Array>(0);
       break;
     }
+
+    Local<Array> nodes = Nan::New<Array>(xpathobj->nodesetval->nodeNr);
+    for (int i = 0; i != xpathobj->nodesetval->nodeNr; ++i) {
+      Nan::Set(nodes, i, XmlNode::New(xpathobj->nodesetval->nodeTab[i]));
+    }
+
+    res = nodes;
+    break;
+  }
+
+  case XPATH_BOOLEAN:
+    res = Nan::New<Boolean>(xpathobj->boolval);
+    break;
+
+  case XPATH_NUMBER:
+    res = Nan::New<Number>(xpathobj->floatval);
+    break;
+
+  case XPATH_STRING:
+    res = Nan::New<String>((const char *)xpathobj->stringval,
+                           xmlStrlen(xpathobj->stringval))
+              .ToLocalChecked();
+    break;
+
+  default:
+    res = Nan::Null();
+    break;
   }
 
-  xmlXPathFreeObject(xpathobj);
   return scope.Escape(res);
 }
 
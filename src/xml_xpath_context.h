@@ -13,10 +13,64 @@ public:
   explicit XmlXpathContext(xmlNode *node);
   ~XmlXpathContext();
 
+  // setup the bindings for the compiled expression cache
+  static void Initialize(v8::Local<v8::Object> target);
+
+  // look the expression up in the cache of compiled expressions,
+  // compiling it on a miss. When `cached` is false the caller owns
+  // the returned expression. Returns NULL for invalid expressions.
+  static xmlXPathCompExpr *compile(const xmlChar *xpath, bool *cached);
+
+  // how the result of an evaluation is handed back to js
+  enum ResultMode {
+    // node sets as arrays of node wrappers, anything else as is
+    RESULT_NODES,
+    // the xpath string() of the result, no wrappers are created
+    RESULT_STRING,
+    // the xpath number() of the result, no wrappers are created
+    RESULT_NUMBER,
+    // the string-value of every node of a node set
+    RESULT_STRINGS,
+    // the values of the attribute nodes of a node set
+    RESULT_ATTR_VALUES,
+    // the number of nodes in a node set
+    RESULT_COUNT
+  };
+
   void register_ns(const xmlChar *prefix, const xmlChar *uri);
-  v8::Local<v8::Value> evaluate(const xmlChar *xpath);
+
+  // register the namespace argument of find(), either the uri of the
+  // default namespace or a {prefix: uri} object
+  void register_namespaces(v8::Local<v8::Value> namespaces);
+
+  // bind {name: value} for use as $name in expressions, after any
+  // namespaces have been registered. Strings,
+  // numbers, booleans, nodes and arrays of nodes are supported.
+  // Returns false (with an exception pending) for unsupported values.
+  bool register_variables(v8::Local<v8::Value> variables);
+
+  // evaluate an xpath string or compiled XPathExpression
+  v8::Local<v8::Value> evaluate(v8::Local<v8::Value> xpath,
+                                ResultMode mode = RESULT_NODES);
+
+  // same as evaluate(), but hands back the result as is,
+  // the caller owns it. Returns NULL when evaluation failed.
+  xmlXPathObject *evaluate_object(v8::Local<v8::Value> xpath);
 
   xmlXPathContext *ctxt;
+
+protected:
+  // false while the shared context of the document is being used
+  bool owned;
+
+  // variables must not outlive the query on a shared context
+  bool has_variables;
+
+  static v8::Local<v8::Value> to_value(xmlXPathObject *xpathobj);
+  static v8::Local<v8::Value> to_strings(xmlNodeSet *nodes, bool attrs_only);
+
+  static NAN_METHOD(SetCacheSize);
+  static NAN_METHOD(CacheStats);
 };
 } // namespace libxmljs
 
@@ -0,0 +1,61 @@
+// Copyright 2009, Squish Tech, LLC.
+
+#include "xml_xpath_expression.h"
+#include "xml_syntax_error.h"
+
+using namespace v8;
+
+namespace libxmljs {
+
+Nan::Persistent<FunctionTemplate> XmlXPathExpression::constructor_template;
+
+// expression
+NAN_METHOD(XmlXPathExpression::New) {
+  NAN_CONSTRUCTOR_CHECK(XPathExpression)
+  Nan::HandleScope scope;
+
+  LIBXMLJS_ARGUMENT_TYPE_CHECK(info[0], IsString,
+                               "Bad argument: expression must be a string");
+
+  Nan::Utf8String expression(info[0]);
+
+  xmlResetLastError();
+  xmlXPathCompExpr *comp =
+      xmlXPathCompile(reinterpret_cast<const xmlChar *>(*expression));
+  if (comp == NULL) {
+    xmlError *error = xmlGetLastError();
+    if (error != NULL) {
+      return Nan::ThrowError(XmlSyntaxError::BuildSyntaxError(error));
+    }
+    return Nan::ThrowError("Invalid XPath expression");
+  }
+
+  XmlXPathExpression *compiled = new XmlXPathExpression(comp);
+  compiled->Wrap(info.This());
+
+  Nan::Set(info.This(), Nan::New<String>("expression").ToLocalChecked(),
+           info[0])
+      .Check();
+
+  return info.GetReturnValue().Set(info.This());
+}
+
+XmlXPathExpression::XmlXPathExpression(xmlXPathCompExpr *comp)
+    : xml_obj(comp) {}
+
+XmlXPathExpression::~XmlXPathExpression() { xmlXPathFreeCompExpr(xml_obj); }
+
+void XmlXPathExpression::Initialize(Local<Object> target) {
+  Nan::HandleScope scope;
+
+  Local<FunctionTemplate> tmpl = Nan::New<FunctionTemplate>(New);
+  tmpl->SetClassName(Nan::New<String>("XPathExpression").ToLocalChecked());
+
+  constructor_template.Reset(tmpl);
+  tmpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::Set(target, Nan::New<String>("XPathExpression").ToLocalChecked(),
+           Nan::GetFunction(tmpl).ToLocalChecked());
+}
+
+} // namespace libxmljs
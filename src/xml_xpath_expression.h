@@ -0,0 +1,31 @@
+// Copyright 2009, Squish Tech, LLC.
+#ifndef SRC_XML_XPATH_EXPRESSION_H_
+#define SRC_XML_XPATH_EXPRESSION_H_
+
+#include <libxml/xpath.h>
+
+#include "libxmljs.h"
+
+namespace libxmljs {
+
+// an xpath expression compiled once, to be evaluated any number of
+// times by find() against any document
+class XmlXPathExpression : public Nan::ObjectWrap {
+public:
+  static Nan::Persistent<v8::FunctionTemplate> constructor_template;
+
+  xmlXPathCompExpr *xml_obj;
+
+  virtual ~XmlXPathExpression();
+
+  static void Initialize(v8::Local<v8::Object> target);
+
+protected:
+  explicit XmlXPathExpression(xmlXPathCompExpr *comp);
+
+  static NAN_METHOD(New);
+};
+
+} // namespace libxmljs
+
+#endif // SRC_XML_XPATH_EXPRESSION_H_
@@ -0,0 +1,141 @@
+// Copyright 2009, Squish Tech, LLC.
+
+#include "xml_xpath_iterator.h"
+#include "xml_node.h"
+
+using namespace v8;
+
+namespace libxmljs {
+
+Nan::Persistent<FunctionTemplate> XmlXPathIterator::constructor_template;
+
+// only created from c++ space, see XmlXPathIterator::New
+NAN_METHOD(XmlXPathIterator::New) {
+  NAN_CONSTRUCTOR_CHECK(XPathIterator)
+  Nan::HandleScope scope;
+
+  return info.GetReturnValue().Set(info.This());
+}
+
+Local<Object> XmlXPathIterator::New(xmlXPathObject *result,
+                                    XmlDocument *document,
+                                    Local<Object> context) {
+  Nan::EscapableHandleScope scope;
+
+  XmlXPathIterator *iterator = new XmlXPathIterator(result, document);
+  Local<Object> obj =
+      Nan::NewInstance(
+          Nan::GetFunction(Nan::New(constructor_template)).ToLocalChecked())
+          .ToLocalChecked();
+  iterator->Wrap(obj);
+
+  // this prevents the context node from going away
+  Nan::Set(obj, Nan::New<String>("context").ToLocalChecked(), context)
+      .Check();
+
+  return scope.Escape(obj);
+}
+
+XmlXPathIterator::XmlXPathIterator(xmlXPathObject *result,
+                                   XmlDocument *document)
+    : xml_obj(result), document(document), position(0) {
+  generation = (document != NULL) ? document->generation : 0;
+  if (document != NULL) {
+    document->Ref();
+  }
+}
+
+XmlXPathIterator::~XmlXPathIterator() { release(); }
+
+void XmlXPathIterator::release() {
+  if (xml_obj != NULL) {
+    xmlXPathFreeObject(xml_obj);
+    xml_obj = NULL;
+  }
+  if (document != NULL) {
+    document->Unref();
+    document = NULL;
+  }
+}
+
+Local<Object> XmlXPathIterator::result(Local<Value> value, bool done) {
+  Nan::EscapableHandleScope scope;
+  Local<Object> res = Nan::New<Object>();
+  Nan::Set(res, Nan::New<String>("value").ToLocalChecked(), value);
+  Nan::Set(res, Nan::New<String>("done").ToLocalChecked(),
+           Nan::New<Boolean>(done));
+  return scope.Escape(res);
+}
+
+NAN_METHOD(XmlXPathIterator::Next) {
+  Nan::HandleScope scope;
+  XmlXPathIterator *iterator =
+      Nan::ObjectWrap::Unwrap<XmlXPathIterator>(info.This());
+  assert(iterator);
+
+  if (iterator->xml_obj == NULL) {
+    return info.GetReturnValue().Set(
+        iterator->result(Nan::Undefined(), true));
+  }
+
+  // the node set points into the tree, it can't be trusted anymore
+  // once the document has changed
+  if ((iterator->document != NULL) &&
+      (iterator->document->generation != iterator->generation)) {
+    iterator->release();
+    return Nan::ThrowError("Document was modified during iteration");
+  }
+
+  xmlNodeSet *nodes = iterator->xml_obj->nodesetval;
+  if (iterator->position >= xmlXPathNodeSetGetLength(nodes)) {
+    iterator->release();
+    return info.GetReturnValue().Set(
+        iterator->result(Nan::Undefined(), true));
+  }
+
+  xmlNode *node = nodes->nodeTab[iterator->position++];
+  return info.GetReturnValue().Set(
+      iterator->result(XmlNode::New(node), false));
+}
+
+// stop iterating early, e.g. on break out of a for...of loop
+NAN_METHOD(XmlXPathIterator::Return) {
+  Nan::HandleScope scope;
+  XmlXPathIterator *iterator =
+      Nan::ObjectWrap::Unwrap<XmlXPathIterator>(info.This());
+  assert(iterator);
+
+  iterator->release();
+  return info.GetReturnValue().Set(iterator->result(info[0], true));
+}
+
+NAN_METHOD(XmlXPathIterator::Length) {
+  Nan::HandleScope scope;
+  XmlXPathIterator *iterator =
+      Nan::ObjectWrap::Unwrap<XmlXPathIterator>(info.This());
+  assert(iterator);
+
+  int length = (iterator->xml_obj != NULL)
+                   ? xmlXPathNodeSetGetLength(iterator->xml_obj->nodesetval)
+                   : 0;
+  return info.GetReturnValue().Set(Nan::New<Int32>(length));
+}
+
+void XmlXPathIterator::Initialize(Local<Object> target) {
+  Nan::HandleScope scope;
+
+  Local<FunctionTemplate> tmpl = Nan::New<FunctionTemplate>(New);
+  tmpl->SetClassName(Nan::New<String>("XPathIterator").ToLocalChecked());
+
+  constructor_template.Reset(tmpl);
+  tmpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::SetPrototypeMethod(tmpl, "next", XmlXPathIterator::Next);
+  Nan::SetPrototypeMethod(tmpl, "return", XmlXPathIterator::Return);
+  Nan::SetPrototypeMethod(tmpl, "length", XmlXPathIterator::Length);
+
+  Nan::Set(target, Nan::New<String>("XPathIterator").ToLocalChecked(),
+           Nan::GetFunction(tmpl).ToLocalChecked());
+}
+
+} // namespace libxmljs
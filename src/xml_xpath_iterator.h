@@ -0,0 +1,51 @@
+// Copyright 2009, Squish Tech, LLC.
+#ifndef SRC_XML_XPATH_ITERATOR_H_
+#define SRC_XML_XPATH_ITERATOR_H_
+
+#include <libxml/xpath.h>
+
+#include "libxmljs.h"
+#include "xml_document.h"
+
+namespace libxmljs {
+
+// iterates over the node set of an xpath result, nodes are only
+// wrapped when they are pulled by next()
+class XmlXPathIterator : public Nan::ObjectWrap {
+public:
+  static Nan::Persistent<v8::FunctionTemplate> constructor_template;
+
+  virtual ~XmlXPathIterator();
+
+  static void Initialize(v8::Local<v8::Object> target);
+
+  // create an iterator over the node set of `result`, which it takes
+  // ownership of. `context` is kept alive while iterating.
+  static v8::Local<v8::Object> New(xmlXPathObject *result,
+                                   XmlDocument *document,
+                                   v8::Local<v8::Object> context);
+
+protected:
+  XmlXPathIterator(xmlXPathObject *result, XmlDocument *document);
+
+  static NAN_METHOD(New);
+  static NAN_METHOD(Next);
+  static NAN_METHOD(Return);
+  static NAN_METHOD(Length);
+
+  // free the node set and let go of the document
+  void release();
+
+  v8::Local<v8::Object> result(v8::Local<v8::Value> value, bool done);
+
+  xmlXPathObject *xml_obj;
+  XmlDocument *document;
+
+  // document generation the node set was evaluated at
+  unsigned int generation;
+  int position;
+};
+
+} // namespace libxmljs
+
+#endif // SRC_XML_XPATH_ITERATOR_H_
@@ -268,6 +268,50 @@ describe('document', () => {
     expect(xmlDocInvalid.validationErrors.length).toBe(1);
   });
 
+  it('compiling leaves the schema document alone', () => {
+    const xsd =
+      '<xs:schema xmlns:xs="http://www.w3.org/2001/XMLSchema"><!-- note -->\n' +
+      '  <xs:element name="comment" type="xs:string"/></xs:schema>';
+    const xsdDoc = libxml.parseXml(xsd);
+    const before = xsdDoc.toString();
+    const element = xsdDoc.get('//*[@name="comment"]');
+
+    const schema = libxml.compileSchema(xsdDoc);
+    expect(libxml.parseXml('<comment/>').validate(xsdDoc)).toBe(true);
+    expect(xsdDoc.toString()).toBe(before);
+
+    // and the compiled schema doesn't depend on it
+    element.remove();
+    xsdDoc.dispose();
+    expect(libxml.parseXml('<comment/>').validate(schema)).toBe(true);
+  });
+
+  it('validate with compiled schema', () => {
+    const xsd =
+      '<xs:schema xmlns:xs="http://www.w3.org/2001/XMLSchema"><xs:element name="comment" type="xs:string"/></xs:schema>';
+    const xml_valid = '<?xml version="1.0"?><comment>A comment</comment>';
+    const xml_invalid = '<?xml version="1.0"?><commentt>A comment</commentt>';
+
+    const schema = libxml.compileSchema(libxml.parseXml(xsd));
+    const xmlDocValid = libxml.parseXml(xml_valid);
+    const xmlDocInvalid = libxml.parseXml(xml_invalid);
+
+    expect(schema).toBeInstanceOf(libxml.Schema);
+
+    for (let i = 0; i < 3; i += 1) {
+      expect(xmlDocValid.validate(schema)).toBe(true);
+      expect(xmlDocValid.validationErrors.length).toBe(0);
+
+      expect(xmlDocInvalid.validate(schema)).toBe(false);
+      expect(xmlDocInvalid.validationErrors.length).toBe(1);
+    }
+
+    expect(() => libxml.compileSchema()).toThrow('document argument required');
+    expect(() => libxml.compileSchema(libxml.parseXml('<foo/>'))).toThrow(
+      'Invalid XSD schema'
+    );
+  });
+
   it('rngValidate', () => {
     // see http://relaxng.org/ for more infos about RELAX NG
 
@@ -324,6 +368,52 @@ describe('document', () => {
     expect(xmlDocInvalid.validationErrors.length).toBe(1);
   });
 
+  it('rngValidate with compiled schema', () => {
+    const rng =
+      '<element name="addressBook" xmlns="http://relaxng.org/ns/structure/1.0">' +
+      '<zeroOrMore>' +
+      '<element name="card">' +
+      '<interleave>' +
+      '<element name="name"><text/></element>' +
+      '<element name="email"><text/></element>' +
+      '</interleave>' +
+      '</element>' +
+      '</zeroOrMore>' +
+      '</element>';
+
+    const xml_valid =
+      '<addressBook>' +
+      '<card><name>John Smith</name><email>js@example.com</email></card>' +
+      '<card><email>fb@example.net</email><name>Fred Bloggs</name></card>' +
+      '</addressBook>';
+
+    const xml_invalid =
+      '<addressBook>' +
+      '<card><Name>John Smith</Name><email>js@example.com</email></card>' +
+      '</addressBook>';
+
+    const schema = libxml.compileRelaxNGSchema(libxml.parseXml(rng));
+    const xmlDocValid = libxml.parseXml(xml_valid);
+    const xmlDocInvalid = libxml.parseXml(xml_invalid);
+
+    expect(schema).toBeInstanceOf(libxml.RelaxNGSchema);
+
+    for (let i = 0; i < 3; i += 1) {
+      expect(xmlDocValid.rngValidate(schema)).toBe(true);
+      expect(xmlDocValid.validationErrors.length).toBe(0);
+
+      expect(xmlDocInvalid.rngValidate(schema)).toBe(false);
+      expect(xmlDocInvalid.validationErrors.length).toBeGreaterThan(0);
+    }
+
+    expect(() => xmlDocValid.validate(schema)).toThrow(
+      'Must pass XmlDocument or Schema'
+    );
+    expect(() =>
+      libxml.compileRelaxNGSchema(libxml.parseXml('<foo/>'))
+    ).toThrow('Invalid RELAX NG schema');
+  });
+
   it('schematronValidate', () => {
     const sch =
       '<schema xmlns="http://purl.oclc.org/dsdl/schematron" queryBinding="xslt2">' +
@@ -379,6 +469,137 @@ describe('document', () => {
     expect(xmlDocInvalid.validationErrors.length).toBe(1);
   });
 
+  it('schematronValidate with compiled schema', () => {
+    const sch =
+      '<schema xmlns="http://purl.oclc.org/dsdl/schematron" queryBinding="xslt2">' +
+      '<pattern id="errors">' +
+      '<rule context="//addr">' +
+      '<assert test="state[last()=1] or @nullFlavor">All //addr elements MUST have element state.</assert>' +
+      '<assert test="streetAddressLine or @nullFlavor">All //addr elements MUST have element streetAddressLine</assert>' +
+      '</rule>' +
+      '</pattern>' +
+      '</schema>';
+
+    const xml_valid =
+      '<ClinicalDocument><addr use="H"><state>24</state>' +
+      '<streetAddressLine>example street</streetAddressLine></addr>' +
+      '</ClinicalDocument>';
+    const xml_invalid =
+      '<ClinicalDocument><addr use="H"><state>24</state></addr>' +
+      '<addr/></ClinicalDocument>';
+
+    const schema = libxml.compileSchematronSchema(libxml.parseXml(sch));
+    const xmlDocValid = libxml.parseXml(xml_valid);
+    const xmlDocInvalid = libxml.parseXml(xml_invalid);
+
+    expect(schema).toBeInstanceOf(libxml.SchematronSchema);
+    expect(schema.errors).toEqual([]);
+
+    // the validation context is reused, errors must not carry over
+    for (let i = 0; i < 3; i += 1) {
+      expect(xmlDocInvalid.schematronValidate(schema)).toBe(false);
+      expect(xmlDocInvalid.validationErrors.length).toBe(3);
+
+      expect(xmlDocValid.schematronValidate(schema)).toBe(true);
+      expect(xmlDocValid.validationErrors.length).toBe(0);
+    }
+
+    expect(() => xmlDocValid.schematronValidate(0)).toThrow(
+      'Must pass XmlDocument or SchematronSchema'
+    );
+
+    // the schema points into its own copy of the document
+    const schDoc = libxml.parseXml(sch);
+    const retained = libxml.compileSchematronSchema(schDoc);
+    const rule = schDoc.get('//*[local-name()="rule"]');
+    rule.attr('context', 'other');
+    rule.remove();
+    schDoc.dispose();
+    expect(retained.errors).toEqual([]);
+    expect(xmlDocInvalid.schematronValidate(retained)).toBe(false);
+    expect(xmlDocInvalid.validationErrors.length).toBe(3);
+  });
+
+  it('validateAsync', async () => {
+    const xsd =
+      '<xs:schema xmlns:xs="http://www.w3.org/2001/XMLSchema"><xs:element name="comment" type="xs:string"/></xs:schema>';
+    const xml_valid = '<?xml version="1.0"?><comment>A comment</comment>';
+    const xml_invalid = '<?xml version="1.0"?><commentt>A comment</commentt>';
+
+    const xsdDoc = libxml.parseXml(xsd);
+    const xmlDocValid = libxml.parseXml(xml_valid);
+    const xmlDocInvalid = libxml.parseXml(xml_invalid);
+
+    let result = await xmlDocValid.validateAsync(xsdDoc);
+    expect(result.valid).toBe(true);
+    expect(result.errors.length).toBe(0);
+
+    result = await xmlDocInvalid.validateAsync(libxml.compileSchema(xsdDoc));
+    expect(result.valid).toBe(false);
+    expect(result.errors.length).toBe(1);
+
+    await expect(xmlDocValid.validateAsync()).rejects.toThrow('Must pass xsd');
+    await expect(
+      xmlDocValid.validateAsync(libxml.parseXml('<foo/>'))
+    ).rejects.toThrow('Invalid XSD schema');
+  });
+
+  it('rngValidateAsync and schematronValidateAsync', async () => {
+    const rng =
+      '<element name="comment" xmlns="http://relaxng.org/ns/structure/1.0">' +
+      '<text/>' +
+      '</element>';
+    const sch =
+      '<schema xmlns="http://purl.oclc.org/dsdl/schematron">' +
+      '<pattern><rule context="/comment">' +
+      '<assert test="@author">A comment MUST have an author.</assert>' +
+      '</rule></pattern>' +
+      '</schema>';
+    const xmlDoc = libxml.parseXml('<comment>A comment</comment>');
+
+    let result = await xmlDoc.rngValidateAsync(libxml.parseXml(rng));
+    expect(result.valid).toBe(true);
+    expect(result.errors.length).toBe(0);
+
+    const schema = libxml.compileSchematronSchema(libxml.parseXml(sch));
+    const results = await Promise.all([
+      xmlDoc.schematronValidateAsync(schema),
+      xmlDoc.schematronValidateAsync(schema),
+    ]);
+    results.forEach((r) => {
+      expect(r.valid).toBe(false);
+      expect(r.errors.length).toBe(1);
+    });
+  });
+
+  it('cannot be modified during async validation', async () => {
+    const xsd =
+      '<xs:schema xmlns:xs="http://www.w3.org/2001/XMLSchema"><xs:element name="comment" type="xs:string"/></xs:schema>';
+    const xmlDoc = libxml.parseXml('<comment>A comment</comment>');
+    const xsdDoc = libxml.parseXml(xsd);
+    const root = xmlDoc.root();
+
+    const pending = xmlDoc.validateAsync(xsdDoc);
+    const busy = 'Document is in use by a background job';
+
+    expect(() => root.text('changed')).toThrow(busy);
+    expect(() => root.attr('foo', 'bar')).toThrow(busy);
+    expect(() => root.node('child')).toThrow(busy);
+    expect(() => root.remove()).toThrow(busy);
+    // the job compiled its own copy of the schema document
+    xsdDoc.root().attr('foo', 'bar');
+    // reading is fine
+    expect(root.text()).toBe('A comment');
+    expect(xmlDoc.toString()).toContain('A comment');
+    expect(root.clone().text()).toBe('A comment');
+
+    const result = await pending;
+    expect(result.valid).toBe(true);
+
+    root.text('changed');
+    expect(root.text()).toBe('changed');
+  });
+
   it('validate memory usage', () => {
     const xsd =
       '<xs:schema xmlns:xs="http://www.w3.org/2001/XMLSchema"><xs:element name="comment" type="xs:string"/></xs:schema>';
@@ -438,6 +659,125 @@ describe('document', () => {
     expect(`${html}\n`).toBe(parsedHtml.toString());
   });
 
+  it('fromObject', () => {
+    const content = {
+      '@id': '7',
+      '@xmlns:x': 'urn:x',
+      item: [{ '@sku': 'a', '#text': 'Apple' }, { '@sku': 'b' }],
+      note: 'fresh & ripe',
+      'x:gift': 'yes',
+      count: 2,
+    };
+    const doc = libxml.Document.fromObject({ order: content });
+
+    expect(doc.root().name()).toBe('order');
+    expect(doc.get('x:gift', { x: 'urn:x' }).text()).toBe('yes');
+    expect(doc.toObject()).toEqual({
+      ...content,
+      '@xmlns:x': undefined,
+      count: '2',
+    });
+
+    const root = doc.root();
+    expect(root.appendObject({ extra: { '@n': 1 }, '#text': 'tail' })).toBe(
+      root
+    );
+    expect(root.get('extra').attr('n').value()).toBe('1');
+    expect(root.toObject()['#text']).toBe('tail');
+
+    // nothing is left behind by a failed build
+    const children = root.childNodes().length;
+    expect(() => root.appendObject({ a: 'x', b: [[1]] })).toThrow(
+      'arrays cannot be nested'
+    );
+    expect(root.childNodes().length).toBe(children);
+
+    expect(() => libxml.Document.fromObject({ a: 1, b: 2 })).toThrow(
+      'exactly one root element'
+    );
+    expect(() => libxml.Document.fromObject({ '@a': 1 })).toThrow(
+      'a document cannot have attributes'
+    );
+  });
+
+  it('toFlatTree', () => {
+    const doc = libxml.parseXml(
+      '<?pi data?><r xmlns:x="urn:x"><x:a>h\u00e9</x:a><!--c--><a/>t</r>'
+    );
+    const tree = doc.toFlatTree();
+
+    expect(tree.length).toBe(7);
+    expect(Array.from(tree.nodeType)).toEqual([7, 1, 1, 3, 8, 1, 3]);
+    expect(Array.from(tree.parent)).toEqual([-1, -1, 1, 2, 1, 1, 1]);
+    expect(Array.from(tree.firstChild)).toEqual([-1, 2, 3, -1, -1, -1, -1]);
+    expect(Array.from(tree.nextSibling)).toEqual([1, -1, 4, -1, 5, 6, -1]);
+    expect(Array.from(tree.nameId, (id) => tree.names[id])).toEqual([
+      'pi',
+      'r',
+      'x:a',
+      undefined,
+      undefined,
+      'a',
+      undefined,
+    ]);
+
+    const text = (i) =>
+      tree.text.toString('utf8', tree.textOffset[i], tree.textOffset[i + 1]);
+    expect(text(0)).toBe('data');
+    expect(text(3)).toBe('h\u00e9');
+    expect(text(4)).toBe('c');
+    expect(text(5)).toBe('');
+  });
+
+  it('dispose', () => {
+    const before = libxml.memoryUsage();
+    const doc = libxml.parseXml(
+      `<root>${'<item a="1">text</item>'.repeat(1000)}</root>`
+    );
+    const root = doc.root();
+    const item = root.child(0);
+    const attr = item.attr('a');
+    const detached = root.child(1).remove();
+    const cursor = doc.cursor();
+    expect(libxml.memoryUsage()).toBeGreaterThan(before);
+
+    doc.dispose();
+    // freed right away, without waiting for the wrappers to be collected
+    expect(libxml.memoryUsage()).toBeLessThanOrEqual(before);
+
+    expect(() => doc.root()).toThrow('Document has been disposed');
+    expect(() => doc.toString()).toThrow('Document has been disposed');
+    expect(() => root.name()).toThrow('Node has been freed');
+    expect(() => item.text()).toThrow('Node has been freed');
+    expect(() => attr.value()).toThrow('Node has been freed');
+    expect(() => detached.name()).toThrow('Node has been freed');
+    expect(() => cursor.name()).toThrow('Document has been disposed');
+    expect(() => new libxml.Element(doc, 'new')).toThrow(
+      'Document has been disposed'
+    );
+    expect(() => libxml.parseXml('<a/>').root().addChild(root)).toThrow(
+      'Node has been freed'
+    );
+
+    // disposing twice is fine
+    doc.dispose();
+  });
+
+  it('dispose is refused while the document is in use', async () => {
+    const xsdDoc = libxml.parseXml(
+      '<xs:schema xmlns:xs="http://www.w3.org/2001/XMLSchema"><xs:element name="comment" type="xs:string"/></xs:schema>'
+    );
+    const schema = libxml.compileSchema(xsdDoc);
+
+    const xmlDoc = libxml.parseXml('<comment>A comment</comment>');
+    const pending = xmlDoc.validateAsync(schema);
+    expect(() => xmlDoc.dispose()).toThrow(
+      'Document is in use by a background job and cannot be disposed'
+    );
+    expect((await pending).valid).toBe(true);
+    xmlDoc.dispose();
+  });
+
   it('validate rng memory usage', () => {
     const rng =
       '<element name="addressBook" xmlns="http://relaxng.org/ns/structure/1.0">' +
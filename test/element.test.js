@@ -244,4 +244,46 @@ describe('element', () => {
     expect(cdataResult).toBe(element);
     expect(element.toString()).toContain('[CDATA[cdata]]');
   });
+
+  it('toObject', () => {
+    const doc = libxml.parseXml(
+      '<order id="7" xmlns:x="urn:x">\n' +
+        '  <item sku="a">Apple</item>\n' +
+        '  <item sku="b"/>\n' +
+        '  <note>fresh<![CDATA[ & ripe]]></note>\n' +
+        '  <x:gift>yes</x:gift>\n' +
+        '  <__proto__>p</__proto__>\n' +
+        '</order>'
+    );
+
+    const order = doc.toObject();
+    expect(order).toEqual({
+      '@id': '7',
+      item: [{ '@sku': 'a', '#text': 'Apple' }, { '@sku': 'b' }],
+      note: 'fresh & ripe',
+      'x:gift': 'yes',
+      ['__proto__']: 'p',
+    });
+    expect(Object.getPrototypeOf(order)).toBe(Object.prototype);
+
+    expect(
+      doc.root().toObject({
+        attributePrefix: '',
+        textKey: '_',
+        alwaysArray: ['note'],
+        namespaces: 'uri',
+      })
+    ).toMatchObject({
+      id: '7',
+      item: [{ sku: 'a', _: 'Apple' }, { sku: 'b' }],
+      note: ['fresh & ripe'],
+      '{urn:x}gift': 'yes',
+    });
+    expect(doc.get('x:gift', { x: 'urn:x' }).toObject()).toBe('yes');
+    expect(doc.toObject({ namespaces: 'local' }).gift).toBe('yes');
+
+    expect(() => doc.toObject({ namespaces: 'none' })).toThrow(
+      "namespaces must be 'prefix', 'local' or 'uri'"
+    );
+  });
 });
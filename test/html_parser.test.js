@@ -127,6 +127,56 @@ describe('html parser', () => {
     }
   });
 
+  it('parse async', async () => {
+    const filename = `${__dirname}/fixtures/parser.html`;
+
+    // Parse via a string and via a Buffer
+    for (const encoding of ['utf8', null]) {
+      // eslint-disable-next-line no-sync
+      const str = fs.readFileSync(filename, encoding);
+
+      // eslint-disable-next-line no-await-in-loop
+      const doc = await libxml.parseHtmlAsync(str);
+
+      expect(doc.root().name()).toBe('html');
+      expect(doc.get('head/title').text()).toBe('Test HTML document');
+      expect(doc.get('body/span').text()).toBe('HTML content!');
+    }
+  });
+
+  it('recoverable parse async', async () => {
+    const recoverableFile = `${__dirname}/fixtures/warnings/amp.html`;
+    // eslint-disable-next-line no-sync
+    const str = fs.readFileSync(recoverableFile, 'utf8');
+
+    const doc = await libxml.parseHtmlAsync(str);
+    const syncDoc = libxml.parseHtml(str);
+
+    expect(doc.errors.length).toBe(4);
+    for (const [i, error] of syncDoc.errors.entries()) {
+      expect(doc.errors[i].code).toBe(error.code);
+      expect(doc.errors[i].message).toBe(error.message);
+      expect(doc.errors[i].line).toBe(error.line);
+    }
+  });
+
+  it('parseOptions async', async () => {
+    let doc = await libxml.parseHtmlAsync('<a/>', {
+      excludeImpliedElements: true,
+    });
+
+    expect(doc.toString().indexOf('DOCTYPE') === -1).toBeTruthy();
+    expect(doc.toString().indexOf('<html>') === -1).toBeTruthy();
+
+    doc = await libxml.parseHtmlAsync('<a/>', { doctype: false });
+    expect(doc.toString().indexOf('DOCTYPE') === -1).toBeTruthy();
+    expect(doc.toString().indexOf('body') > -1).toBeTruthy();
+
+    await expect(libxml.parseHtmlAsync('<a/>', 'nope')).rejects.toThrow(
+      'fromHtmlAsync options must be an object'
+    );
+  });
+
   it('parseOptions', () => {
     let doc = libxml
       .parseHtml('<a/>', { doctype: false, implied: false })
@@ -1,3 +1,4 @@
+const crypto = require('node:crypto');
 const libxml = require('../index');
 
 if (!global.gc) {
@@ -51,6 +52,55 @@ describe('memory management', () => {
     });
   });
 
+  it('large inaccessible document freed in the background', () =>
+    new Promise((done) => {
+      const xml_memory_before_document = libxml.memoryUsage();
+
+      // keep every thread of the pool busy, the document can only be
+      // freed once they are done
+      const threads = Number(process.env.UV_THREADPOOL_SIZE) || 4;
+      let busy = threads;
+      const release = () => {
+        busy -= 1;
+        if (busy > 0) {
+          return;
+        }
+
+        const deadline = Date.now() + 5000;
+        const check = () => {
+          const freed = libxml.memoryUsage() <= xml_memory_before_document;
+          if (freed || Date.now() > deadline) {
+            expect(freed).toBeTruthy();
+            done();
+          } else {
+            setTimeout(check, 10);
+          }
+        };
+        check();
+      };
+      for (let i = 0; i < threads; i += 1) {
+        crypto.pbkdf2('secret', 'salt', 500000, 64, 'sha512', release);
+      }
+
+      libxml.parseXml(`<root>${'<item>text</item>'.repeat(20000)}</root>`);
+      collectGarbage();
+      expect(libxml.memoryUsage()).toBeGreaterThan(xml_memory_before_document);
+    }), 20000);
+
+  it('large document with wrapped nodes freed in place', () => {
+    const source = libxml.parseXml(
+      `<root>${'<item>text</item>'.repeat(20000)}</root>`
+    );
+    const root = source.root();
+    let target = new libxml.Document();
+    target.root(root);
+
+    // the wrapper of the moved root holds on to its old document only
+    target = null;
+    collectGarbage();
+    expect(() => root.name()).toThrow('Node has been freed');
+  });
+
   it('inaccessible document freed when node freed', () =>
     new Promise((done) => {
       const xml_memory_before_document = libxml.memoryUsage();
@@ -48,6 +48,32 @@ describe('node attributes', () => {
     }
   });
 
+  it('setAttributes', () => {
+    const doc = libxml.parseXml('<root xmlns:x="urn:x" to="a"/>');
+    const elem = doc.root();
+
+    expect(elem.setAttributes({ to: 'b', count: 2, 'x:id': 'c' })).toBe(elem);
+    expect(elem.attrsObject()).toEqual({ to: 'b', count: '2', 'x:id': 'c' });
+    expect(elem.attr('id').namespace().href()).toBe('urn:x');
+  });
+
+  it('attrsObject', () => {
+    const doc = libxml.parseXml(
+      '<root xmlns:x="urn:x" foo="bar" x:foo="baz" amp="a&amp;b"/>'
+    );
+    const elem = doc.root();
+
+    expect(elem.attrsObject()).toEqual({
+      foo: 'bar',
+      'x:foo': 'baz',
+      amp: 'a&b',
+    });
+    expect(new libxml.Document().node('e').attrsObject()).toEqual({});
+
+    expect(elem.getAttribute('amp')).toBe('a&b');
+    expect(elem.getAttribute('missing')).toBeNull();
+  });
+
   it('siblings', () => {
     const doc = new libxml.Document();
     const elem = doc
@@ -165,6 +165,50 @@ describe('ref integrity', () => {
     expect(leaf.name()).toBe('left');
   });
 
+  it('unlinked_tree_persistence_after_move', () => {
+    const doc = makeDocument();
+    const leaf = doc.get('//center');
+    let inner = doc.get('//inner');
+    let target = new libxml.Element(doc, 'target');
+
+    inner.remove();
+    target.addChild(inner);
+    inner = null;
+    target = null;
+    collectGarbage();
+
+    expect(leaf.parent().name()).toBe('inner');
+    expect(leaf.parent().parent().name()).toBe('target');
+  });
+
+  it('unlinked_tree_persistence_after_replace', () => {
+    const doc = makeDocument();
+    const leaf = doc.get('//center');
+    let middle = doc.get('//middle');
+
+    middle.replace(new libxml.Element(doc, 'other'));
+    middle = null;
+    collectGarbage();
+
+    expect(leaf.parent().parent().name()).toBe('middle');
+    expect(doc.get('//other')).toBeTruthy();
+  });
+
+  it('unlinked_tree_persistence_with_namespace', () => {
+    const doc = libxml.parseXml(
+      '<root><outer xmlns:x="urn:x"><x:inner/></outer></root>'
+    );
+    let outer = doc.get('//outer');
+    const ns = doc.get('//x:inner', { x: 'urn:x' }).namespace();
+
+    outer.remove();
+    outer = null;
+    collectGarbage();
+
+    expect(ns.href()).toBe('urn:x');
+    expect(ns.prefix()).toBe('x');
+  });
+
   it('set_text_clobbering_children', () => {
     const doc = libxml.parseHtml(
       '<root><child><inner>old</inner></child></root>'
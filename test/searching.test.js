@@ -14,6 +14,411 @@ describe('searching', () => {
     expect(doc.get('child').get('grandchild')).toBe(grandchild);
   });
 
+  it('compiled expressions', () => {
+    const doc = libxml.parseXml(
+      '<root xmlns:ex="urn:example"><child/><ex:child/><child/></root>'
+    );
+    const children = libxml.compileXPath('child');
+    const prefixed = libxml.compileXPath('//ex:child');
+
+    expect(children).toBeInstanceOf(libxml.XPathExpression);
+    expect(children.expression).toBe('child');
+
+    for (let i = 0; i < 3; i += 1) {
+      expect(doc.find(children).length).toBe(2);
+      expect(doc.get(children)).toBe(doc.root().child(0));
+      expect(doc.find(prefixed, { ex: 'urn:example' }).length).toBe(1);
+    }
+
+    // compiled expressions do not belong to a document
+    const other = libxml.parseXml('<root><child/></root>');
+    expect(other.find(children).length).toBe(1);
+    expect(other.root().find(libxml.compileXPath('count(//child)'))).toBe(1);
+
+    expect(() => libxml.compileXPath('//[')).toThrow();
+    expect(() => libxml.compileXPath()).toThrow(
+      'Bad argument: expression must be a string'
+    );
+  });
+
+  it('expression cache', () => {
+    const doc = libxml.parseXml('<root><child/><child/></root>');
+    const start = libxml.xpathCacheStats();
+
+    for (let i = 0; i < 5; i += 1) {
+      expect(doc.find('//child[position() > 0]').length).toBe(2);
+    }
+
+    let stats = libxml.xpathCacheStats();
+    expect(stats.misses - start.misses).toBe(1);
+    expect(stats.hits - start.hits).toBe(4);
+    expect(stats.size).toBeLessThanOrEqual(stats.capacity);
+
+    libxml.setXPathCacheSize(0);
+    stats = libxml.xpathCacheStats();
+    expect(stats.size).toBe(0);
+    expect(doc.find('//child[position() > 0]').length).toBe(2);
+    expect(libxml.xpathCacheStats().size).toBe(0);
+
+    libxml.setXPathCacheSize(1);
+    doc.find('//child');
+    doc.find('/root/child');
+    expect(doc.find('/root/child').length).toBe(2);
+    expect(libxml.xpathCacheStats().size).toBe(1);
+
+    libxml.setXPathCacheSize(start.capacity);
+    expect(() => libxml.setXPathCacheSize(-1)).toThrow(RangeError);
+    expect(() => libxml.setXPathCacheSize(NaN)).toThrow(RangeError);
+    expect(() => libxml.setXPathCacheSize(Infinity)).toThrow(RangeError);
+    expect(() => libxml.setXPathCacheSize(2 ** 64)).toThrow(RangeError);
+    expect(libxml.xpathCacheStats().capacity).toBe(start.capacity);
+  });
+
+  it('registered namespaces', () => {
+    const doc = libxml.parseXml(
+      '<env:Envelope xmlns:env="urn:envelope" xmlns:b="urn:body">' +
+        '<env:Body><b:item>1</b:item><b:item>2</b:item></env:Body>' +
+        '</env:Envelope>'
+    );
+
+    expect(
+      doc.registerXPathNamespaces({ e: 'urn:envelope', b: 'urn:body' })
+    ).toBe(doc);
+
+    expect(doc.find('/e:Envelope/e:Body/b:item').length).toBe(2);
+    const body = doc.get('e:Body');
+    expect(body.name()).toBe('Body');
+    expect(body.find('b:item').length).toBe(2);
+    expect(body.get('b:item[2]').text()).toBe('2');
+    expect(doc.get('count(//b:item)')).toBe(2);
+
+    // per call namespaces are added without changing the registered ones
+    expect(body.find('x:item', { x: 'urn:body' }).length).toBe(2);
+    expect(body.find('b:item', { x: 'urn:body' }).length).toBe(2);
+    // an unknown prefix makes the evaluation fail
+    expect(body.find('x:item')).toBeUndefined();
+
+    doc.registerXPathNamespaces({ b: null });
+    expect(body.find('b:item')).toBeUndefined();
+    expect(body.find('e:*').length).toBe(0);
+
+    expect(() => doc.registerXPathNamespaces('urn:body')).toThrow(
+      'Bad argument: namespaces must be an object'
+    );
+  });
+
+  it('evaluateMany', () => {
+    const doc = libxml.parseXml(
+      '<order xmlns:p="urn:price"><id>42</id><customer>Jane</customer>' +
+        '<line><p:amount>2.5</p:amount></line>' +
+        '<line><p:amount>1.5</p:amount></line></order>'
+    );
+    const fields = {
+      id: 'id',
+      customer: libxml.compileXPath('customer'),
+      missing: 'nope',
+      total: 'sum(line/p:amount)',
+    };
+    const namespaces = { p: 'urn:price' };
+
+    expect(doc.root().evaluateMany(fields, { namespaces })).toEqual({
+      id: '42',
+      customer: 'Jane',
+      missing: '',
+      total: '4',
+    });
+    expect(doc.evaluateMany(fields, { as: 'number', namespaces })).toEqual({
+      id: 42,
+      customer: NaN,
+      missing: NaN,
+      total: 4,
+    });
+
+    const nodes = doc.evaluateMany(
+      { lines: 'line', count: 'count(line)' },
+      { as: 'nodes' }
+    );
+    expect(nodes.lines.length).toBe(2);
+    expect(nodes.lines[0]).toBe(doc.get('line'));
+    expect(nodes.count).toBe(2);
+
+    expect(() => doc.evaluateMany({ id: 'id' }, { as: 'boolean' })).toThrow(
+      "Bad argument: as must be 'string', 'number' or 'nodes'"
+    );
+    expect(() => doc.evaluateMany('id')).toThrow(
+      'Bad argument: expressions must be an object'
+    );
+  });
+
+  it('wrapper free results', () => {
+    const doc = libxml.parseXml(
+      '<list xmlns:x="urn:x"><item id="a">one</item>' +
+        '<item id="b">t<b>w</b>o</item><x:item id="c"/></list>'
+    );
+
+    expect(doc.findStrings('item')).toEqual(['one', 'two']);
+    expect(doc.root().findStrings('//x:item/@id', { x: 'urn:x' })).toEqual([
+      'c',
+    ]);
+    expect(doc.findStrings('item/text()')).toEqual(['one', 't', 'o']);
+    expect(doc.findStrings('missing')).toEqual([]);
+
+    expect(doc.findAttrValues('//@id')).toEqual(['a', 'b', 'c']);
+    expect(doc.findAttrValues('//item | //item/@id')).toEqual(['a', 'b']);
+
+    expect(doc.count('//item')).toBe(2);
+    expect(doc.count(libxml.compileXPath('//*'))).toBe(5);
+    expect(doc.count('missing')).toBe(0);
+
+    expect(() => doc.count('count(//item)')).toThrow(
+      'XPath expression must select a node set'
+    );
+    expect(() => doc.findStrings('string(//item)')).toThrow(
+      'XPath expression must select a node set'
+    );
+  });
+
+  it('iterate', () => {
+    const doc = libxml.parseXml(
+      '<list><item>1</item><item>2</item><item>3</item></list>'
+    );
+
+    const values = [];
+    for (const item of doc.iterate('item')) {
+      values.push(item.text());
+    }
+    expect(values).toEqual(['1', '2', '3']);
+
+    const it = doc.root().iterate(libxml.compileXPath('item'));
+    expect(it.length()).toBe(3);
+    expect(it.next().value).toBe(doc.get('item'));
+    expect(it.return()).toEqual({ value: undefined, done: true });
+    expect(it.length()).toBe(0);
+    expect(it.next()).toEqual({ value: undefined, done: true });
+
+    // break calls return() and releases the node set
+    const seen = [];
+    const items = doc.iterate('item');
+    for (const item of items) {
+      seen.push(item);
+      break;
+    }
+    expect(seen.length).toBe(1);
+    expect(items.length()).toBe(0);
+
+    expect(() => doc.iterate('count(item)')).toThrow(
+      'XPath expression must select a node set'
+    );
+    expect(() => doc.iterate('item[')).toThrow(
+      'Could not evaluate XPath expression'
+    );
+  });
+
+  it('iterate fails once the document changed', () => {
+    const doc = libxml.parseXml('<list><item/><item/><item/></list>');
+    const it = doc.iterate('item');
+
+    it.next().value.remove();
+    expect(() => it.next()).toThrow('Document was modified during iteration');
+    expect(it.next().done).toBe(true);
+  });
+
+  it('iterate survives calls that leave the tree alone', () => {
+    const doc = libxml.parseXml('<list><item/><item/><item/></list>');
+    const copies = libxml.parseXml('<copies/>');
+    const cursor = doc.cursor();
+
+    let count = 0;
+    for (const item of doc.iterate('item')) {
+      copies.root().addChild(item.clone());
+      libxml.Element(doc, 'detached');
+      expect(() => doc.root(item)).toThrow(
+        'Holder document already has a root node'
+      );
+      count += 1;
+    }
+    expect(count).toBe(3);
+    expect(copies.root().childNodes().length).toBe(3);
+    expect(cursor.firstChild()).toBe(true);
+    expect(cursor.name()).toBe('list');
+  });
+
+  it('variables', () => {
+    const doc = libxml.parseXml(
+      '<stock><item sku="a&quot;1" qty="3"/><item sku="b2" qty="0"/></stock>'
+    );
+    const bySku = libxml.compileXPath('item[@sku = $sku]');
+    const start = libxml.xpathCacheStats();
+
+    expect(doc.get(bySku, null, { sku: 'a"1' }).attr('qty').value()).toBe(
+      '3'
+    );
+    expect(doc.get(bySku, null, { sku: 'b2' }).attr('qty').value()).toBe('0');
+    for (const sku of ['a"1', 'b2', 'c3']) {
+      doc.find('item[@sku = $sku]', null, { sku });
+    }
+    expect(libxml.xpathCacheStats().misses - start.misses).toBe(1);
+
+    expect(doc.count('item[@qty > $min]', null, { min: 1 })).toBe(1);
+    expect(doc.find('$flag', null, { flag: true })).toBe(true);
+
+    const first = doc.get('item');
+    expect(doc.find('$nodes/@sku', null, { nodes: [first] }).length).toBe(1);
+    expect(doc.findStrings('$node/@qty', null, { node: first })).toEqual([
+      '3',
+    ]);
+    expect(
+      doc.evaluateMany({ qty: 'item[@sku = $sku]/@qty' }, {
+        variables: { sku: 'b2' },
+      })
+    ).toEqual({ qty: '0' });
+
+    // variables do not stick to a shared context
+    doc.registerXPathNamespaces({ s: 'urn:stock' });
+    expect(doc.count('item[@sku = $sku]', null, { sku: 'b2' })).toBe(1);
+    expect(doc.find('item[@sku = $sku]')).toBeUndefined();
+
+    expect(() => doc.find('$v', null, { v: {} })).toThrow(
+      'Unsupported value for variable $v'
+    );
+  });
+
+  it('attribute index', () => {
+    const doc = libxml.parseXml(
+      '<list><item id="a" sku="x"/><item id="b" sku="y"/><item sku="x"/></list>'
+    );
+    const items = doc.find('item');
+
+    expect(doc.buildIndex({ attribute: ['sku'] })).toBe(doc);
+    expect(doc.lookup('sku', 'x')).toBe(items[0]);
+    expect(doc.lookup('sku', 'z')).toBeNull();
+    expect(doc.getElementById('b')).toBe(items[1]);
+    expect(doc.getElementById('c')).toBeNull();
+
+    // rebuilt once the document changed
+    items[0].remove();
+    expect(doc.lookup('sku', 'x')).toBe(items[2]);
+    items[2].attr({ id: 'c' });
+    expect(doc.getElementById('c')).toBe(items[2]);
+    expect(doc.getElementById('a')).toBeNull();
+
+    // updated along with the tree
+    const added = doc.root().node('item');
+    added.attr({ sku: 'w' });
+    expect(doc.lookup('sku', 'w')).toBe(added);
+    added.attr('sku').value('v');
+    expect(doc.lookup('sku', 'w')).toBeNull();
+    expect(doc.lookup('sku', 'v')).toBe(added);
+    items[2].addPrevSibling(items[0]);
+    expect(doc.lookup('sku', 'x')).toBe(items[0]);
+    items[0].attr('sku').remove();
+    expect(doc.lookup('sku', 'x')).toBe(items[2]);
+    const copy = items[2].clone();
+    expect(doc.lookup('sku', 'x')).toBe(items[2]);
+    doc.root().child(0).addPrevSibling(copy);
+    expect(doc.lookup('sku', 'x')).toBe(copy);
+    doc.root().appendObject({ item: { '@sku': 'u' } });
+    expect(doc.lookup('sku', 'u').name()).toBe('item');
+
+    // and left by elements moved to another document
+    const other = new libxml.Document();
+    other.root(doc.root());
+    expect(doc.lookup('sku', 'u')).toBeNull();
+    other.buildIndex({ attribute: ['sku'] });
+    expect(other.lookup('sku', 'u').name()).toBe('item');
+
+    // xml:id is registered by the parser
+    const xmlId = libxml.parseXml('<r><e xml:id="x1"/><e id="x1"/></r>');
+    expect(xmlId.getElementById('x1')).toBe(xmlId.get('e'));
+    expect(xmlId.lookup('xml:id', 'x1')).toBe(xmlId.get('e'));
+  });
+
+  it('tag name index', () => {
+    const doc = libxml.parseXml(
+      '<list xmlns:x="urn:x"><item/><group><item/><x:item/></group></list>'
+    );
+    const group = doc.get('group');
+
+    expect(doc.getElementsByTagName('item').length).toBe(3);
+    expect(doc.getElementsByTagName('item', null).length).toBe(2);
+    expect(doc.getElementsByTagName('item', 'urn:x')).toEqual([
+      group.child(1),
+    ]);
+    expect(group.getElementsByTagName('item').length).toBe(2);
+    expect(doc.getElementsByTagName('missing')).toEqual([]);
+
+    // "//name" is answered from the index, in document order
+    expect(doc.find('//item')).toEqual(doc.find('//item[true()]'));
+    expect(group.count('//item')).toBe(2);
+
+    // rebuilt once the document changed
+    group.node('item');
+    expect(doc.find('//item').length).toBe(3);
+    expect(doc.getElementsByTagName('item', null)[2].parent()).toBe(group);
+
+    // removed subtrees are searched directly
+    group.remove();
+    expect(doc.count('//item')).toBe(1);
+    expect(group.getElementsByTagName('item').length).toBe(3);
+
+    // and so are documents whose root moved to another document
+    expect(doc.getElementsByTagName('list').length).toBe(1);
+    new libxml.Document().root(doc.root());
+    expect(doc.getElementsByTagName('list')).toEqual([]);
+    expect(doc.getElementsByTagName('item')).toEqual([]);
+  });
+
+  it('css selectors', () => {
+    const doc = libxml.parseHtml(
+      '<html><body><div id="main" class="box wide"><p>one</p>' +
+        '<p class="note">two</p><span lang="en-US"></span></div>' +
+        '<ul><li>a</li><li>b</li><li>c</li></ul></body></html>'
+    );
+    const main = doc.get('//div');
+    const lis = doc.find('//li');
+
+    expect(doc.querySelector('#main')).toBe(main);
+    expect(doc.querySelector('DIV.box.wide')).toBe(main);
+    expect(doc.querySelector('.missing')).toBeNull();
+    expect(doc.querySelectorAll('div > p').length).toBe(2);
+    expect(doc.querySelector('p + p').text()).toBe('two');
+    expect(doc.querySelectorAll('p ~ span, .note').length).toBe(2);
+    expect(doc.querySelector('[lang|=en]').name()).toBe('span');
+    expect(doc.querySelectorAll('[class~=wide], [lang^=en]').length).toBe(2);
+    expect(doc.querySelector(':root').name()).toBe('html');
+    expect(doc.querySelectorAll('span:empty').length).toBe(1);
+    expect(doc.querySelectorAll('li:nth-child(odd)')).toEqual([
+      lis[0],
+      lis[2],
+    ]);
+    expect(doc.querySelector('li:last-child')).toBe(lis[2]);
+    expect(doc.querySelectorAll('li:not(:first-child, :last-child)')).toEqual(
+      [lis[1]]
+    );
+
+    // scoped to descendants, combinators may still reach above the scope
+    expect(main.querySelectorAll('p').length).toBe(2);
+    expect(main.querySelector('body p')).toBe(main.child(0));
+    expect(main.querySelector('li')).toBeNull();
+    expect(main.querySelector('div')).toBeNull();
+
+    // duplicated ids, the first one is not always the match
+    const dups = libxml.parseXml(
+      '<root xmlns:x="urn:x"><div id="a"/><b x:id="a"/>' +
+        '<section><span id="a"/><i id="a"/></section></root>'
+    );
+    const section = dups.get('//section');
+    expect(dups.querySelector('span#a')).toBe(section.child(0));
+    expect(section.querySelector('#a')).toBe(section.child(0));
+    expect(dups.querySelectorAll('#a').length).toBe(3);
+    expect(dups.querySelector('b#a')).toBeNull();
+    expect(dups.querySelector('b[id]')).toBeNull();
+
+    expect(() => doc.querySelector('div >')).toThrow(
+      'Invalid selector: div >'
+    );
+  });
+
   it('get_missing', () => {
     const doc = new libxml.Document();
 
@@ -102,4 +102,103 @@ describe('traversal', () => {
     expect(child.prevElement().prevElement()).toBe(null);
     expect(child.nextElement().nextElement()).toBe(null);
   });
+
+  it('cursor', () => {
+    const doc = libxml.parseXml(
+      '<root a="1">text<child b="2"><grandchild/></child><!--c--></root>'
+    );
+    const cursor = doc.cursor();
+
+    expect(cursor.type()).toBe('document');
+    expect(cursor.name()).toBe(null);
+    expect(cursor.firstChild()).toBe(true);
+    expect(cursor.name()).toBe('root');
+    expect(cursor.attr('a')).toBe('1');
+    expect(cursor.attr('missing')).toBe(null);
+
+    expect(cursor.firstChild()).toBe(true);
+    expect(cursor.type()).toBe('text');
+    expect(cursor.text()).toBe('text');
+    expect(cursor.attr('a')).toBe(null);
+    expect(cursor.prevSibling()).toBe(false);
+
+    expect(cursor.nextElementSibling()).toBe(true);
+    expect(cursor.name()).toBe('child');
+    expect(cursor.node()).toBe(doc.get('//child'));
+    expect(cursor.firstElementChild()).toBe(true);
+    expect(cursor.name()).toBe('grandchild');
+    expect(cursor.firstChild()).toBe(false);
+    expect(cursor.nextSibling()).toBe(false);
+    expect(cursor.name()).toBe('grandchild');
+
+    expect(cursor.parent()).toBe(true);
+    expect(cursor.nextSibling()).toBe(true);
+    expect(cursor.type()).toBe('comment');
+    expect(cursor.nextElementSibling()).toBe(false);
+
+    expect(cursor.parent()).toBe(true);
+    expect(cursor.lastChild()).toBe(true);
+    expect(cursor.text()).toBe('c');
+    expect(cursor.parent()).toBe(true);
+    expect(cursor.parent()).toBe(true);
+    expect(cursor.node()).toBe(doc);
+    expect(cursor.parent()).toBe(false);
+
+    const element = doc.get('//child').cursor();
+    expect(element.name()).toBe('child');
+    expect(element.text()).toBe('');
+
+    doc.root().node('added');
+    expect(() => cursor.name()).toThrow();
+    expect(() => element.firstChild()).toThrow();
+  });
+
+  it('walk', () => {
+    const doc = libxml.parseXml(
+      '<root><a>x<b/></a><!--c--><skip><d/></skip><?pi data?></root>'
+    );
+    const visited = [];
+    doc.root().walk((name, type, depth) => {
+      visited.push([name, type, depth]);
+      return name !== 'skip';
+    });
+    expect(visited).toEqual([
+      ['root', 1, 0],
+      ['a', 1, 1],
+      [null, 3, 2],
+      ['b', 1, 2],
+      [null, 8, 1],
+      ['skip', 1, 1],
+      ['pi', 7, 1],
+    ]);
+
+    const names = [];
+    doc.root().walk((name) => names.push(name), { types: [1], maxDepth: 1 });
+    expect(names).toEqual(['root', 'a', 'skip']);
+
+    const nodes = [];
+    doc.root().walk(
+      (name, type, depth, cursor) => {
+        nodes.push(cursor.node());
+      },
+      { types: [8] }
+    );
+    expect(nodes.length).toBe(1);
+    expect(nodes[0].text()).toBe('c');
+
+    // creating detached nodes doesn't change the tree
+    let visits = 0;
+    doc.root().walk(() => {
+      visits += 1;
+      libxml.Element(doc, 'detached');
+    });
+    expect(visits).toBe(8);
+
+    expect(() =>
+      doc.root().walk((name, type, depth, cursor) => {
+        cursor.node().remove();
+      })
+    ).toThrow('Document was modified during walk');
+    expect(() => doc.root().walk(null)).toThrow();
+  });
 });
@@ -121,6 +121,67 @@ describe('xml parser', () => {
     expect(err.code).toBe(errorControl.code);
   });
 
+  it('parse_async', async () => {
+    const filename = `${__dirname}/fixtures/parser.xml`;
+    // eslint-disable-next-line no-sync
+    const str = fs.readFileSync(filename, 'utf8');
+
+    const doc = await libxml.parseXmlAsync(str);
+
+    expect(doc.version()).toBe('1.0');
+    expect(doc.root().name()).toBe('root');
+    expect(doc.get('child/grandchild').text()).toBe('with love');
+    expect(doc.errors.length).toBe(0);
+    expect(doc.toString()).toBe(str);
+  });
+
+  it('parse_async_buffer', async () => {
+    const filename = `${__dirname}/fixtures/parser-utf16.xml`;
+    // eslint-disable-next-line no-sync
+    const buf = fs.readFileSync(filename);
+
+    const doc = await libxml.parseXmlAsync(buf);
+
+    expect(doc.encoding()).toBe('UTF-16');
+    expect(doc.root().name()).toBe('root');
+  });
+
+  it('parse_async_recoverable', async () => {
+    const filename = `${__dirname}/fixtures/warnings/ent9.xml`;
+    // eslint-disable-next-line no-sync
+    const str = fs.readFileSync(filename, 'utf8');
+
+    const doc = await libxml.parseXmlAsync(str);
+
+    expect(doc.errors.length).toBe(1);
+    expect(doc.errors[0].code).toBe(201);
+    expect(doc.errors[0].str1).toBe('prefix');
+  });
+
+  it('parse_async_fatal_error', async () => {
+    const filename = `${__dirname}/fixtures/errors/comment.xml`;
+    // eslint-disable-next-line no-sync
+    const str = fs.readFileSync(filename, 'utf8');
+
+    await expect(libxml.parseXmlAsync(str)).rejects.toMatchObject({
+      domain: 1,
+      code: 4,
+      line: 5,
+    });
+  });
+
+  it('parse_async_concurrent', async () => {
+    const docs = await Promise.all(
+      Array.from({ length: 8 }, (_, i) =>
+        libxml.parseXmlAsync(`<root><child n="${i}"/></root>`)
+      )
+    );
+
+    docs.forEach((doc, i) => {
+      expect(doc.get('child').attr('n').value()).toBe(String(i));
+    });
+  });
+
   it('text path', () => {
     const xml = '<?xml version="1.0" encoding="utf-8"?><Name>Test</Name>';
     const doc = libxml.parseXmlString(xml);